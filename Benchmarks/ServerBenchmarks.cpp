@@ -0,0 +1,191 @@
+// Microbenchmarks for the server's per-message hot paths: frame reassembly,
+// command parsing, reply framing and broadcast encoding/fan-out. Sockets are
+// replaced by in-memory streams, so the numbers are the server's own work.
+//
+// Usage: ServerBenchmarks [--benchmark_filter=Fanout] [--benchmark_min_time=0.2]
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "Commands.h"
+#include "Frame.h"
+#include "FrameCodec.h"
+#include "OutputQueue.h"
+#include "RecvBuffer.h"
+
+static const size_t STREAM_FRAMES = 1024;
+static const size_t READ_SIZE = 1500;   // One Ethernet-sized recv per readiness event
+
+static std::string makeText(size_t length) {
+    std::string text(length, 'x');
+    for (size_t i = 0; i < length; i++) {
+        text[i] = static_cast<char>('a' + i % 26);
+    }
+    return text;
+}
+
+// A client's byte stream: STREAM_FRAMES chat lines of the given size.
+static std::string makeStream(int protocol, size_t payload) {
+    std::string text = makeText(payload);
+    std::string stream;
+    for (size_t i = 0; i < STREAM_FRAMES; i++) {
+        if (protocol == PROTOCOL_V1) {
+            encodeV1(stream, text.data(), text.size());
+        }
+        else {
+            encodeV2(stream, FRAME_TEXT, text.data(), text.size());
+        }
+    }
+    return stream;
+}
+
+// The server's read loop: copy one "recv" worth of bytes into the buffer (the
+// scratch block when nothing is pending), decode every complete frame in
+// place, then settle the partial frame left at the end into a pool block.
+static void BM_Reassembly(benchmark::State& state) {
+    int protocol = static_cast<int>(state.range(0));
+    std::string stream = makeStream(protocol, static_cast<size_t>(state.range(1)));
+    BufferPool pool;
+    std::unique_ptr<char[]> scratch(new char[BufferPool::largestBlock()]);
+    size_t frames = 0;
+
+    for (auto _ : state) {
+        RecvBuffer input;
+        size_t offset = 0;
+        while (offset < stream.size()) {
+            if (!input.attached()) {
+                input.borrow(scratch.get(), BufferPool::largestBlock());
+            }
+            else if (input.writable() == 0) {
+                input.compact();
+            }
+            size_t chunk = std::min({ READ_SIZE, input.writable(), stream.size() - offset });
+            memcpy(input.writePtr(), stream.data() + offset, chunk);
+            input.produce(chunk);
+            offset += chunk;
+
+            for (;;) {
+                DecodedFrame frame;
+                DecodeResult result = decodeFrame(protocol, input.readPtr(), input.readable(), frame);
+                if (result == DECODE_NEED_MORE) {
+                    input.reserve(pool, frame.frameSize);
+                    break;
+                }
+                if (result == DECODE_ERROR) {
+                    state.SkipWithError("decode error");
+                    return;
+                }
+                benchmark::DoNotOptimize(frame.payload);
+                input.consume(frame.frameSize);
+                frames++;
+            }
+            input.settle(pool, 256);
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * stream.size()));
+    state.SetItemsProcessed(static_cast<int64_t>(frames));
+}
+BENCHMARK(BM_Reassembly)->ArgNames({ "protocol", "payload" })
+    ->Args({ PROTOCOL_V1, 32 })->Args({ PROTOCOL_V1, 200 })
+    ->Args({ PROTOCOL_V2, 32 })->Args({ PROTOCOL_V2, 200 })->Args({ PROTOCOL_V2, 4096 });
+
+// Command recognition in processMessage: name lookup, argument tokenizing and
+// the password redaction applied before the command log.
+static void BM_CommandParse(benchmark::State& state) {
+    static const char* commands[] = {
+        "~login alice hunter2",
+        "~send bob hello there, how are you today?",
+        "~msg #general the build is green again",
+        "~getlog 50",
+        "~register carol correct-horse-battery",
+        "~nosuchcommand with arguments",
+    };
+    const size_t count = sizeof(commands) / sizeof(commands[0]);
+    size_t next = 0;
+
+    for (auto _ : state) {
+        std::string_view message(commands[next]);
+        next = (next + 1 == count) ? 0 : next + 1;
+
+        std::string_view command = message.substr(1);
+        Tokenizer args(command);
+        CommandId id = lookupCommand(args.next());
+        benchmark::DoNotOptimize(loggableCommand(id, command));
+        benchmark::DoNotOptimize(args.next());
+        benchmark::DoNotOptimize(args.remainder());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CommandParse);
+
+// A reply to one client: sendMessage's framing for its protocol.
+static void BM_ReplyFrame(benchmark::State& state) {
+    int protocol = static_cast<int>(state.range(0));
+    std::string text = makeText(static_cast<size_t>(state.range(1)));
+
+    for (auto _ : state) {
+        FramePtr frame = Frame::create(text.data(), text.size(), protocol);
+        benchmark::DoNotOptimize(frame->data(protocol));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+}
+BENCHMARK(BM_ReplyFrame)->ArgNames({ "protocol", "payload" })
+    ->Args({ PROTOCOL_V1, 64 })->Args({ PROTOCOL_V1, 1000 })
+    ->Args({ PROTOCOL_V2, 64 })->Args({ PROTOCOL_V2, 1000 });
+
+// A multi-line reply (~getlist, ~getlog): one frame per line on v1, batches on v2.
+static void BM_ReplyLines(benchmark::State& state) {
+    int protocol = static_cast<int>(state.range(0));
+    std::vector<std::string> lines(static_cast<size_t>(state.range(1)), makeText(40) + "\n");
+
+    for (auto _ : state) {
+        std::vector<FramePtr> frames;
+        Frame::createLines(lines, protocol, frames);
+        benchmark::DoNotOptimize(frames.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * lines.size()));
+}
+BENCHMARK(BM_ReplyLines)->ArgNames({ "protocol", "lines" })
+    ->Args({ PROTOCOL_V1, 100 })->Args({ PROTOCOL_V2, 100 });
+
+// A public message reaching every client of a reactor: encode once, queue the
+// shared frame on each connection (mixed protocols), then drain every queue
+// through a fake socket that accepts whatever one gathered write offers.
+static void BM_Fanout(benchmark::State& state) {
+    std::string text = makeText(static_cast<size_t>(state.range(0)));
+    size_t clients = static_cast<size_t>(state.range(1));
+    std::vector<OutputQueue> queues(clients);
+    IoBuffer buffers[64];
+    uint64_t sequence = 0;
+    size_t written = 0;
+
+    for (auto _ : state) {
+        FramePtr frame = Frame::createChat(++sequence, text.data(), text.size());
+        for (size_t i = 0; i < clients; i++) {
+            queues[i].push(frame, (i % 4 == 0) ? PROTOCOL_V1 : PROTOCOL_V2);
+        }
+        for (OutputQueue& queue : queues) {
+            while (!queue.empty()) {
+                size_t count = queue.gather(buffers, 64);
+                size_t sent = 0;
+                for (size_t i = 0; i < count; i++) {
+                    sent += ioBufferLength(buffers[i]);
+                }
+                written += sent;
+                queue.markSent(sent);
+            }
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(written));
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * clients));
+}
+BENCHMARK(BM_Fanout)->ArgNames({ "payload", "clients" })
+    ->ArgsProduct({ { 32, 256, 4096 }, { 10, 100, 1000 } });
+
+BENCHMARK_MAIN();
@@ -0,0 +1,659 @@
+// Drives a running chat server with many simulated clients and reports
+// throughput and end-to-end latency. Every chat line carries the send time,
+// so the delay until another client receives it is measured on one clock.
+//
+// Usage: LoadGenerator --port=N [--host=127.0.0.1] [--clients=1000] [--duration=10]
+//                      [--rate=2000] [--mix=public:80,send:15,getlist:3,getlog:2]
+//                      [--protocol=2] [--size=64] [--prefix=lg] [--password=loadtest]
+//                      [--drain=2] [--seed=1] [--compress]
+// Logging in thousands of clients means thousands of password hashes; start
+// the server with a low --kdf-cost (e.g. 8) for load runs.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Compression.h"
+#include "FrameCodec.h"
+#include "Metrics.h"
+#include "Platform.h"
+#include "Poller.h"
+#include "Status.h"
+
+enum Operation {
+    OP_PUBLIC,
+    OP_SEND,
+    OP_GETLIST,
+    OP_GETLOG,
+    OP_COUNT
+};
+
+static const char* OPERATION_NAMES[OP_COUNT] = { "public", "send", "getlist", "getlog" };
+
+struct LoadOptions {
+    std::string host;
+    uint16_t port;
+    int clients;
+    int durationSeconds;
+    int drainSeconds;
+    double rate;             // Operations per second across all clients
+    int mix[OP_COUNT];       // Relative weights
+    int protocol;
+    size_t payloadSize;      // Bytes of padding-inclusive chat text
+    std::string prefix;      // Usernames are <prefix><index>
+    std::string password;
+    unsigned seed;
+    bool compress;           // Ask for deflate (v2 only)
+
+    LoadOptions()
+        : host("127.0.0.1"), port(0), clients(1000), durationSeconds(10), drainSeconds(2), rate(2000),
+          mix{ 80, 15, 3, 2 }, protocol(PROTOCOL_V2), payloadSize(64), prefix("lg"), password("loadtest"), seed(1), compress(false) {}
+};
+
+enum ClientState {
+    CLIENT_CONNECTING,
+    CLIENT_LOGGING_IN,
+    CLIENT_READY,
+    CLIENT_FAILED
+};
+
+struct PendingCommand {
+    Operation operation;
+    std::chrono::steady_clock::time_point sentAt;
+};
+
+struct Client {
+    SOCKET socket;
+    std::string name;
+    ClientState state;
+    int protocol;              // Of frames from the server; v2 once it answers the hello
+    int sendProtocol;          // Of frames to the server; v2 right after our hello
+    std::string input;
+    std::string output;
+    std::deque<PendingCommand> pending;   // ~getlist/~getlog awaiting their reply, in order
+    uint64_t skipLines;        // v1 ~getlog body lines still to come
+    std::unique_ptr<InflateStream> inflate;   // Once compression was requested
+
+    Client() : socket(INVALID_SOCKET), state(CLIENT_CONNECTING), protocol(PROTOCOL_V1), sendProtocol(PROTOCOL_V1), skipLines(0) {}
+};
+
+struct LoadReport {
+    Histogram publicLatency;
+    Histogram privateLatency;
+    Histogram replyLatency[OP_COUNT];
+    Histogram loginLatency;
+    uint64_t sent[OP_COUNT];
+    uint64_t publicReceived;
+    uint64_t privateReceived;
+    uint64_t bytesReceived;
+    uint64_t bytesInflated;    // What FRAME_DEFLATE payloads expanded to
+    uint64_t busyReplies;
+    uint64_t failures;
+
+    LoadReport() : sent{}, publicReceived(0), privateReceived(0), bytesReceived(0), bytesInflated(0), busyReplies(0), failures(0) {}
+};
+
+static const std::chrono::steady_clock::time_point START = std::chrono::steady_clock::now();
+static const char STAMP[] = "LG ";   // Chat lines are "LG <ns since start> <padding>"
+
+static uint64_t nowNanos() {
+    return elapsedNanos(START);
+}
+
+static bool connectInProgress() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EINPROGRESS;
+#endif
+}
+
+class LoadGenerator {
+private:
+    LoadOptions options;
+    std::unique_ptr<Poller> poller;
+    std::vector<PollEvent> readyEvents;
+    std::vector<Client> clients;
+    std::vector<size_t> readyClients;   // Indexes of logged-in clients
+    LoadReport report;
+    std::mt19937 random;
+    int mixTotal;
+
+    void queueFrame(Client& client, std::string_view text) {
+        if (client.sendProtocol == PROTOCOL_V2) {
+            encodeV2(client.output, FRAME_TEXT, text.data(), text.size());
+        }
+        else {
+            encodeV1(client.output, text.data(), text.size());
+        }
+        flush(client);
+    }
+
+    void updateInterest(size_t index) {
+        Client& client = clients[index];
+        uint32_t events = POLLER_READ;
+        if (poller->edgeTriggered() || !client.output.empty() || client.state == CLIENT_CONNECTING) {
+            events |= POLLER_WRITE;
+        }
+        poller->modify(client.socket, events, index);
+    }
+
+    void fail(Client& client) {
+        if (client.state != CLIENT_FAILED) {
+            client.state = CLIENT_FAILED;
+            report.failures++;
+            poller->remove(client.socket);
+            closesocket(client.socket);
+        }
+    }
+
+    void flush(Client& client) {
+        while (!client.output.empty() && client.state != CLIENT_CONNECTING && client.state != CLIENT_FAILED) {
+            int result = send(client.socket, client.output.data(), static_cast<int>(client.output.size()), MSG_NOSIGNAL);
+            if (result < 0) {
+                if (!socketWouldBlock()) {
+                    fail(client);
+                }
+                return;
+            }
+            client.output.erase(0, static_cast<size_t>(result));
+        }
+    }
+
+    std::string stampedText() {
+        std::string text = STAMP + std::to_string(nowNanos()) + " ";
+        if (text.size() < options.payloadSize) {
+            text.append(options.payloadSize - text.size(), 'x');
+        }
+        return text;
+    }
+
+    static bool stampedLatency(std::string_view text, uint64_t& latency) {
+        size_t at = text.find(STAMP);
+        if (at == std::string_view::npos) {
+            return false;
+        }
+        uint64_t sentAt = std::strtoull(std::string(text.substr(at + 3, 20)).c_str(), nullptr, 10);
+        uint64_t now = nowNanos();
+        latency = (now > sentAt) ? now - sentAt : 0;
+        return true;
+    }
+
+    void commandReply(Client& client, Operation operation) {
+        if (client.pending.empty() || client.pending.front().operation != operation) {
+            return;
+        }
+        report.replyLatency[operation].record(elapsedNanos(client.pending.front().sentAt));
+        client.pending.pop_front();
+    }
+
+    // One text line from the server. chat is true for v2 public messages,
+    // which come as their own frame type.
+    void handleText(size_t index, std::string_view text, bool chat) {
+        Client& client = clients[index];
+        if (client.state == CLIENT_LOGGING_IN) {
+            if (text.find("Login successful") != std::string_view::npos) {
+                client.state = CLIENT_READY;
+                readyClients.push_back(index);
+                report.loginLatency.record(nowNanos());
+            }
+            else if (text.find("not found") != std::string_view::npos || text.find("Invalid password") != std::string_view::npos ||
+                     text.find("already logged in") != std::string_view::npos) {
+                fail(client);
+            }
+            return;
+        }
+        if (client.skipLines > 0) {
+            client.skipLines--;
+            return;
+        }
+
+        uint64_t latency;
+        if (text.rfind("[Private to ", 0) == 0) {
+            return;   // Our own confirmation
+        }
+        if (text.rfind("[Private from ", 0) == 0) {
+            if (stampedLatency(text, latency)) {
+                report.privateLatency.record(latency);
+                report.privateReceived++;
+            }
+            return;
+        }
+        if ((chat || client.protocol == PROTOCOL_V1) && stampedLatency(text, latency)) {
+            report.publicLatency.record(latency);
+            report.publicReceived++;
+            return;
+        }
+        if (text.rfind("Active clients:", 0) == 0) {
+            commandReply(client, OP_GETLIST);
+        }
+        else if (text.rfind("Public messages ", 0) == 0 || text.rfind("No public messages", 0) == 0) {
+            commandReply(client, OP_GETLOG);
+            // v1 gets one frame per line; v2 packs the lines into the same batch
+            unsigned long long first = 0, last = 0;
+            if (client.protocol == PROTOCOL_V1 && sscanf(std::string(text).c_str(), "Public messages %llu-%llu", &first, &last) == 2) {
+                client.skipLines = last - first + 1;
+            }
+        }
+        else if (text.rfind("Server busy", 0) == 0) {
+            report.busyReplies++;
+            if (!client.pending.empty()) {
+                client.pending.pop_front();
+            }
+        }
+    }
+
+    void parseInput(size_t index) {
+        Client& client = clients[index];
+        size_t offset = 0;
+        while (offset < client.input.size() && client.state != CLIENT_FAILED) {
+            const char* data = client.input.data() + offset;
+            size_t available = client.input.size() - offset;
+            if (client.protocol == PROTOCOL_V1 && data[0] == '\0') {
+                uint8_t version;
+                DecodeResult hello = decodeHello(data, available, version);
+                if (hello == DECODE_NEED_MORE) {
+                    break;
+                }
+                if (hello == DECODE_ERROR) {
+                    fail(client);
+                    return;
+                }
+                client.protocol = (version >= PROTOCOL_V2) ? PROTOCOL_V2 : PROTOCOL_V1;
+                offset += HELLO_SIZE;
+                continue;
+            }
+
+            DecodedFrame frame;
+            DecodeResult result = decodeFrame(client.protocol, data, available, frame);
+            if (result == DECODE_NEED_MORE) {
+                break;
+            }
+            if (result == DECODE_ERROR) {
+                fail(client);
+                return;
+            }
+            offset += frame.frameSize;
+            handleFrame(index, frame);
+        }
+        client.input.erase(0, offset);
+    }
+
+    void handleFrame(size_t index, const DecodedFrame& frame) {
+        Client& client = clients[index];
+        if (frame.type == FRAME_CHAT) {
+            uint64_t sequence;
+            const char* text;
+            size_t length;
+            if (decodeChat(frame, sequence, text, length)) {
+                handleText(index, std::string_view(text, length), true);
+            }
+        }
+        else if (frame.type == FRAME_PING) {
+            encodeV2(client.output, FRAME_PONG, frame.payload, frame.length);
+            flush(client);
+        }
+        else if (frame.type == FRAME_DEFLATE) {
+            // A run of whole v2 frames, inflated against everything before it
+            std::string inflated;
+            if (!client.inflate || !client.inflate->decompress(frame.payload, frame.length, inflated)) {
+                fail(client);
+                return;
+            }
+            report.bytesInflated += inflated.size();
+            size_t at = 0;
+            DecodedFrame inner;
+            while (at < inflated.size() && decodeV2(inflated.data() + at, inflated.size() - at, inner) == DECODE_OK) {
+                handleFrame(index, inner);
+                at += inner.frameSize;
+            }
+        }
+        else if (frame.type == FRAME_BATCH) {
+            BatchReader reader(frame.payload, frame.length);
+            DecodedFrame line;
+            bool first = true;
+            while (reader.next(line) == DECODE_OK) {
+                std::string_view text(line.payload, line.length);
+                if (first) {
+                    handleText(index, text, false);
+                    first = false;
+                    if (text.rfind("Public messages ", 0) == 0) {
+                        break;   // The rest of the batch is the log itself
+                    }
+                }
+            }
+        }
+        else if (frame.type == FRAME_TEXT) {
+            handleText(index, std::string_view(frame.payload, frame.length), false);
+        }
+    }
+
+    void readClient(size_t index) {
+        Client& client = clients[index];
+        char buffer[64 * 1024];
+        while (client.state != CLIENT_FAILED) {
+            int result = recv(client.socket, buffer, sizeof(buffer), 0);
+            if (result < 0 && socketWouldBlock()) {
+                break;
+            }
+            if (result <= 0) {
+                fail(client);
+                return;
+            }
+            report.bytesReceived += static_cast<uint64_t>(result);
+            client.input.append(buffer, static_cast<size_t>(result));
+        }
+        parseInput(index);
+    }
+
+    void connected(size_t index) {
+        Client& client = clients[index];
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(client.socket, SOL_SOCKET, SO_ERROR, (char*)&error, &length) != 0 || error != 0) {
+            fail(client);
+            return;
+        }
+        client.state = CLIENT_LOGGING_IN;
+        if (options.protocol >= PROTOCOL_V2) {
+            // The server reads everything after the hello as v2
+            encodeHello(client.output, static_cast<uint8_t>(options.protocol));
+            client.sendProtocol = PROTOCOL_V2;
+            if (options.compress) {
+                client.inflate.reset(new InflateStream());
+                client.inflate->init();
+                encodeV2(client.output, FRAME_COMPRESS, CODEC_DEFLATE, strlen(CODEC_DEFLATE));
+            }
+        }
+        // Register and login are pipelined; registering an existing name just fails
+        queueFrame(client, "~register " + client.name + " " + options.password);
+        queueFrame(client, "~login " + client.name + " " + options.password);
+    }
+
+    void handleEvents(int timeoutMs) {
+        if (poller->wait(readyEvents, timeoutMs) != SUCCESS) {
+            return;
+        }
+        for (const PollEvent& event : readyEvents) {
+            size_t index = static_cast<size_t>(event.token);
+            Client& client = clients[index];
+            if (client.state == CLIENT_FAILED) {
+                continue;
+            }
+            if (client.state == CLIENT_CONNECTING && (event.events & (POLLER_WRITE | POLLER_ERROR))) {
+                connected(index);
+                if (client.state != CLIENT_FAILED) {
+                    updateInterest(index);
+                }
+                continue;
+            }
+            if (event.events & POLLER_WRITE) {
+                flush(client);
+            }
+            if (client.state != CLIENT_FAILED && (event.events & (POLLER_READ | POLLER_ERROR))) {
+                readClient(index);
+            }
+            if (client.state != CLIENT_FAILED && !poller->edgeTriggered()) {
+                updateInterest(index);
+            }
+        }
+    }
+
+    Operation pickOperation() {
+        int roll = static_cast<int>(random() % static_cast<unsigned>(mixTotal));
+        for (int op = 0; op < OP_COUNT; op++) {
+            if (roll < options.mix[op]) {
+                return static_cast<Operation>(op);
+            }
+            roll -= options.mix[op];
+        }
+        return OP_PUBLIC;
+    }
+
+    void issue(Operation operation) {
+        size_t index = readyClients[random() % readyClients.size()];
+        Client& client = clients[index];
+        if (client.state != CLIENT_READY) {
+            return;
+        }
+        switch (operation) {
+        case OP_PUBLIC:
+            queueFrame(client, stampedText());
+            break;
+        case OP_SEND: {
+            const Client& target = clients[readyClients[random() % readyClients.size()]];
+            queueFrame(client, "~send " + target.name + " " + stampedText());
+            break;
+        }
+        case OP_GETLIST:
+        case OP_GETLOG:
+            client.pending.push_back(PendingCommand{ operation, std::chrono::steady_clock::now() });
+            queueFrame(client, (operation == OP_GETLIST) ? "~getlist" : "~getlog tail 20");
+            break;
+        case OP_COUNT:
+            break;
+        }
+        report.sent[operation]++;
+        if (!poller->edgeTriggered() && client.state != CLIENT_FAILED) {
+            updateInterest(index);
+        }
+    }
+
+public:
+    LoadGenerator(const LoadOptions& options)
+        : options(options), poller(createPoller(defaultPollerType())), random(options.seed), mixTotal(0) {
+        for (int weight : options.mix) {
+            mixTotal += weight;
+        }
+    }
+
+    int connectAll() {
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(options.port);
+        if (inet_pton(AF_INET, options.host.c_str(), &address.sin_addr) != 1) {
+            std::cerr << "Bad host address " << options.host << "\n";
+            return PARAMETER_ERROR;
+        }
+
+        clients.resize(static_cast<size_t>(options.clients));
+        for (size_t i = 0; i < clients.size(); i++) {
+            Client& client = clients[i];
+            client.name = options.prefix + std::to_string(i);
+            client.socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            if (client.socket == INVALID_SOCKET || setNonBlocking(client.socket) == SOCKET_ERROR) {
+                std::cerr << "Cannot create socket " << i << " (error " << lastSocketError() << "); raise the open file limit?\n";
+                return CAPACITY_ERROR;
+            }
+            int noDelay = 1;
+            setsockopt(client.socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+            if (connect(client.socket, (SOCKADDR*)&address, sizeof(address)) == SOCKET_ERROR && !connectInProgress()) {
+                std::cerr << "Cannot connect client " << i << " (error " << lastSocketError() << ")\n";
+                return CONNECT_ERROR;
+            }
+            if (poller->add(client.socket, POLLER_READ | POLLER_WRITE, i) != SUCCESS) {
+                std::cerr << "Poller cannot take client " << i << "\n";
+                return CAPACITY_ERROR;
+            }
+            // Keep the accept backlog from overflowing while connecting thousands
+            if (i % 64 == 63) {
+                handleEvents(0);
+            }
+        }
+
+        // Wait for every login to finish (or fail), giving up after a while
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+        while (readyClients.size() + report.failures < clients.size() && std::chrono::steady_clock::now() < deadline) {
+            handleEvents(10);
+        }
+        return readyClients.empty() ? CONNECT_ERROR : SUCCESS;
+    }
+
+    void drive() {
+        auto start = std::chrono::steady_clock::now();
+        auto end = start + std::chrono::seconds(options.durationSeconds);
+        uint64_t issued = 0;
+        while (std::chrono::steady_clock::now() < end) {
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            uint64_t due = static_cast<uint64_t>(elapsed * options.rate);
+            // Catch up in bounded steps so replies keep being read under overload
+            for (int burst = 0; issued < due && burst < 256; burst++, issued++) {
+                issue(pickOperation());
+            }
+            handleEvents(1);
+        }
+        auto drainEnd = std::chrono::steady_clock::now() + std::chrono::seconds(options.drainSeconds);
+        while (std::chrono::steady_clock::now() < drainEnd) {
+            handleEvents(10);
+        }
+    }
+
+    void print(double loginSeconds) {
+        double seconds = static_cast<double>(options.durationSeconds);
+        uint64_t total = 0;
+        for (uint64_t count : report.sent) {
+            total += count;
+        }
+        std::cout << "Clients: " << readyClients.size() << "/" << clients.size() << " logged in in "
+            << loginSeconds << " s (" << report.failures << " failed)\n"
+            << "Logins completed at: ";
+        formatHistogram(std::cout, report.loginLatency, true);
+        std::cout << " after start\n"
+            << "Sent: " << total << " operations in " << seconds << " s (" << static_cast<uint64_t>(total / seconds) << "/s):";
+        for (int op = 0; op < OP_COUNT; op++) {
+            std::cout << " " << OPERATION_NAMES[op] << " " << report.sent[op];
+        }
+        std::cout << "\nReceived: " << report.publicReceived << " public deliveries ("
+            << static_cast<uint64_t>(report.publicReceived / seconds) << "/s), " << report.privateReceived << " private, "
+            << report.bytesReceived << " bytes";
+        if (report.bytesInflated > 0) {
+            std::cout << " (" << report.bytesInflated << " after inflating)";
+        }
+        std::cout << ", " << report.busyReplies << " busy replies\n"
+            << "Public delivery latency: ";
+        formatHistogram(std::cout, report.publicLatency, true);
+        std::cout << "\nPrivate delivery latency: ";
+        formatHistogram(std::cout, report.privateLatency, true);
+        std::cout << "\n~getlist reply latency: ";
+        formatHistogram(std::cout, report.replyLatency[OP_GETLIST], true);
+        std::cout << "\n~getlog reply latency: ";
+        formatHistogram(std::cout, report.replyLatency[OP_GETLOG], true);
+        std::cout << "\n";
+    }
+
+    void close() {
+        for (Client& client : clients) {
+            if (client.socket != INVALID_SOCKET && client.state != CLIENT_FAILED) {
+                closesocket(client.socket);
+            }
+        }
+    }
+};
+
+static bool parseMix(const std::string& text, int mix[OP_COUNT]) {
+    for (int op = 0; op < OP_COUNT; op++) {
+        mix[op] = 0;
+    }
+    size_t at = 0;
+    while (at < text.size()) {
+        size_t end = text.find(',', at);
+        std::string item = text.substr(at, (end == std::string::npos) ? std::string::npos : end - at);
+        size_t colon = item.find(':');
+        bool known = false;
+        for (int op = 0; op < OP_COUNT && colon != std::string::npos; op++) {
+            if (item.compare(0, colon, OPERATION_NAMES[op]) == 0) {
+                mix[op] = std::atoi(item.c_str() + colon + 1);
+                known = true;
+            }
+        }
+        if (!known) {
+            return false;
+        }
+        at = (end == std::string::npos) ? text.size() : end + 1;
+    }
+    return mix[OP_PUBLIC] + mix[OP_SEND] + mix[OP_GETLIST] + mix[OP_GETLOG] > 0;
+}
+
+int main(int argc, char* argv[]) {
+    LoadOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--host=", 0) == 0) {
+            options.host = arg.substr(7);
+        }
+        else if (arg.rfind("--port=", 0) == 0) {
+            options.port = static_cast<uint16_t>(std::atoi(arg.c_str() + 7));
+        }
+        else if (arg.rfind("--clients=", 0) == 0) {
+            options.clients = std::atoi(arg.c_str() + 10);
+        }
+        else if (arg.rfind("--duration=", 0) == 0) {
+            options.durationSeconds = std::atoi(arg.c_str() + 11);
+        }
+        else if (arg.rfind("--drain=", 0) == 0) {
+            options.drainSeconds = std::atoi(arg.c_str() + 8);
+        }
+        else if (arg.rfind("--rate=", 0) == 0) {
+            options.rate = std::atof(arg.c_str() + 7);
+        }
+        else if (arg.rfind("--mix=", 0) == 0) {
+            if (!parseMix(arg.substr(6), options.mix)) {
+                std::cerr << "Bad --mix; use e.g. public:80,send:15,getlist:3,getlog:2\n";
+                return 1;
+            }
+        }
+        else if (arg.rfind("--protocol=", 0) == 0) {
+            options.protocol = (std::atoi(arg.c_str() + 11) >= PROTOCOL_V2) ? PROTOCOL_V2 : PROTOCOL_V1;
+        }
+        else if (arg.rfind("--size=", 0) == 0) {
+            options.payloadSize = std::strtoull(arg.c_str() + 7, nullptr, 10);
+        }
+        else if (arg.rfind("--prefix=", 0) == 0) {
+            options.prefix = arg.substr(9);
+        }
+        else if (arg.rfind("--password=", 0) == 0) {
+            options.password = arg.substr(11);
+        }
+        else if (arg.rfind("--seed=", 0) == 0) {
+            options.seed = static_cast<unsigned>(std::strtoul(arg.c_str() + 7, nullptr, 10));
+        }
+        else if (arg == "--compress") {
+            options.compress = true;
+        }
+        else {
+            std::cerr << "Unknown option " << arg << "\n";
+            return 1;
+        }
+    }
+    if (options.port == 0 || options.clients < 1 || options.rate <= 0) {
+        std::cerr << "Usage: " << argv[0] << " --port=N [--host=ADDR] [--clients=N] [--duration=S] [--rate=OPS]"
+            " [--mix=public:W,send:W,getlist:W,getlog:W] [--protocol=1|2] [--size=BYTES] [--prefix=NAME]"
+            " [--password=PW] [--drain=S] [--seed=N] [--compress]\n";
+        return 1;
+    }
+    if (initSockets() != 0) {
+        return 1;
+    }
+
+    LoadGenerator generator(options);
+    auto connectStart = std::chrono::steady_clock::now();
+    if (generator.connectAll() != SUCCESS) {
+        std::cerr << "No client managed to log in\n";
+        generator.close();
+        return 1;
+    }
+    double loginSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - connectStart).count();
+    generator.drive();
+    generator.print(loginSeconds);
+    generator.close();
+    cleanupSockets();
+    return 0;
+}
@@ -0,0 +1,28 @@
+// Prints binary chat log segments (.rlog) written by the server as text.
+// Usage: LogView <segment.rlog> [...]   e.g. LogView public_messages.*.rlog
+
+#include <iostream>
+
+#include "LogRecord.h"
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <file.rlog> [...]\n";
+        return 1;
+    }
+
+    int status = 0;
+    for (int i = 1; i < argc; i++) {
+        LogReader reader;
+        if (!reader.open(argv[i])) {
+            std::cerr << argv[i] << ": not a chat log\n";
+            status = 1;
+            continue;
+        }
+        LogEntry entry;
+        while (reader.next(entry)) {
+            std::cout << "[" << formatLogTimestamp(entry.timestampMicros) << "] " << formatLogEntry(entry) << "\n";
+        }
+    }
+    return status;
+}
@@ -0,0 +1,582 @@
+// Plays a traffic capture (a server started with --capture=PREFIX) against a
+// running server: one connection per captured client, each sending exactly
+// the bytes that client's reads returned, on the captured schedule scaled by
+// --speed (max: as fast as the sockets take them, closing connections only
+// once the replies are in). Reports throughput and response latency, and
+// compares them with an earlier run's --save file.
+//
+// Usage: Replay --port=N [--host=127.0.0.1] [--speed=1|N|max] [--quiet=500]
+//               [--save=FILE] [--baseline=FILE] <capture.rlog> [...]
+// Captured logins only succeed against the same accounts: start the server
+// under test with a copy of the captured server's user store. Segments from
+// several server runs are played back to back.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "FrameCodec.h"
+#include "LogRecord.h"
+#include "Metrics.h"
+#include "Platform.h"
+#include "Poller.h"
+#include "Status.h"
+
+struct ReplayOptions {
+    std::string host;
+    uint16_t port;
+    double speed;            // 0 = as fast as possible
+    int quietMs;             // Done once nothing has arrived for this long after the last send
+    std::string savePath;
+    std::string baselinePath;
+    std::vector<std::string> traces;
+
+    ReplayOptions() : host("127.0.0.1"), port(0), speed(1), quietMs(500) {}
+};
+
+struct TraceEvent {
+    uint64_t at;             // Nanoseconds into the capture
+    uint8_t type;            // LOG_CAPTURE_*
+    size_t connection;       // Index into the replay's connections
+    std::string data;
+};
+
+struct Trace {
+    std::vector<TraceEvent> events;
+    size_t connections;
+    uint64_t frames;         // Complete client frames in the data, hellos included
+    uint64_t bytes;
+
+    Trace() : connections(0), frames(0), bytes(0) {}
+};
+
+// Counts the frames in one captured client's byte stream as it is loaded.
+struct FrameCounter {
+    std::string pending;
+    int protocol;
+    bool lost;               // Malformed stream; stop counting
+
+    FrameCounter() : protocol(PROTOCOL_V1), lost(false) {}
+
+    uint64_t add(std::string_view data) {
+        if (lost) {
+            return 0;
+        }
+        pending.append(data.data(), data.size());
+        uint64_t frames = 0;
+        size_t offset = 0;
+        while (offset < pending.size()) {
+            const char* start = pending.data() + offset;
+            size_t available = pending.size() - offset;
+            if (protocol == PROTOCOL_V1 && start[0] == '\0') {
+                uint8_t version;
+                DecodeResult hello = decodeHello(start, available, version);
+                if (hello == DECODE_NEED_MORE) {
+                    break;
+                }
+                if (hello == DECODE_ERROR) {
+                    lost = true;
+                    break;
+                }
+                protocol = (version >= PROTOCOL_V2) ? PROTOCOL_V2 : PROTOCOL_V1;
+                offset += HELLO_SIZE;
+                frames++;
+                continue;
+            }
+            DecodedFrame frame;
+            DecodeResult result = decodeFrame(protocol, start, available, frame);
+            if (result == DECODE_NEED_MORE) {
+                break;
+            }
+            if (result == DECODE_ERROR) {
+                lost = true;
+                break;
+            }
+            offset += frame.frameSize;
+            frames++;
+        }
+        pending.erase(0, offset);
+        return frames;
+    }
+};
+
+// Reads the capture records of every file in order. Connection ids restart
+// with each server run, and so does the clock: a run is shifted to start
+// where the previous one ended.
+static bool loadTrace(const std::vector<std::string>& paths, Trace& trace) {
+    std::unordered_map<uint32_t, size_t> open;   // Capture id -> connection index
+    std::vector<FrameCounter> counters;
+    uint64_t runStart = 0;
+    uint64_t last = 0;
+    for (const std::string& path : paths) {
+        LogReader reader;
+        if (!reader.open(path)) {
+            std::cerr << path << ": not a chat log\n";
+            return false;
+        }
+        LogEntry entry;
+        while (reader.next(entry)) {
+            uint32_t id;
+            uint64_t nanos;
+            std::string_view data;
+            if (!decodeCapturePayload(entry, id, nanos, data)) {
+                continue;
+            }
+            if (runStart + nanos < last) {
+                runStart = last;
+                open.clear();
+            }
+            TraceEvent event;
+            event.at = runStart + nanos;
+            event.type = entry.type;
+            last = event.at;
+            if (entry.type == LOG_CAPTURE_OPEN) {
+                open[id] = trace.connections++;
+                counters.emplace_back();
+            }
+            auto it = open.find(id);
+            if (it == open.end()) {
+                continue;   // Opened before the capture's first segment
+            }
+            event.connection = it->second;
+            if (entry.type == LOG_CAPTURE_DATA) {
+                event.data.assign(data.data(), data.size());
+                trace.bytes += data.size();
+                trace.frames += counters[event.connection].add(data);
+            }
+            else if (entry.type == LOG_CAPTURE_CLOSE) {
+                open.erase(it);
+            }
+            trace.events.push_back(std::move(event));
+        }
+    }
+    // Start with the first connection, not when the captured server did
+    uint64_t first = trace.events.empty() ? 0 : trace.events.front().at;
+    for (TraceEvent& event : trace.events) {
+        event.at -= first;
+    }
+    return true;
+}
+
+static uint64_t nowNanos() {
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return elapsedNanos(start);
+}
+
+static bool connectInProgress() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EINPROGRESS;
+#endif
+}
+
+enum ConnectionState {
+    CONN_IDLE,               // Not opened yet
+    CONN_CONNECTING,
+    CONN_OPEN,
+    CONN_DONE                // Closed as captured, or failed
+};
+
+struct ReplayConnection {
+    SOCKET socket;
+    ConnectionState state;
+    std::string output;
+    bool closeWhenFlushed;
+    uint64_t waitingSince;   // Send time of the oldest data not yet answered; 0 = none
+
+    ReplayConnection() : socket(INVALID_SOCKET), state(CONN_IDLE), closeWhenFlushed(false), waitingSince(0) {}
+};
+
+struct ReplayReport {
+    Histogram response;      // From a send to the first bytes back on that connection
+    Histogram lateness;      // How far behind the captured schedule sends went out
+    uint64_t bytesSent;
+    uint64_t bytesReceived;
+    uint64_t failures;       // Refused or reset before their captured close
+    uint64_t elapsed;        // From the first event to the last byte in or out
+
+    ReplayReport() : bytesSent(0), bytesReceived(0), failures(0), elapsed(0) {}
+};
+
+class Replayer {
+private:
+    ReplayOptions options;
+    const Trace& trace;
+    std::unique_ptr<Poller> poller;
+    std::vector<PollEvent> readyEvents;
+    std::vector<ReplayConnection> connections;
+    sockaddr_in address;
+    uint64_t start;
+    uint64_t lastTraffic;
+    ReplayReport report;
+
+    void updateInterest(size_t index) {
+        ReplayConnection& conn = connections[index];
+        uint32_t events = POLLER_READ;
+        if (poller->edgeTriggered() || !conn.output.empty() || conn.state == CONN_CONNECTING) {
+            events |= POLLER_WRITE;
+        }
+        poller->modify(conn.socket, events, index);
+    }
+
+    void finish(size_t index, bool failed) {
+        ReplayConnection& conn = connections[index];
+        if (conn.state == CONN_DONE) {
+            return;
+        }
+        if (failed) {
+            report.failures++;
+        }
+        if (conn.socket != INVALID_SOCKET) {
+            poller->remove(conn.socket);
+            closesocket(conn.socket);
+            conn.socket = INVALID_SOCKET;
+        }
+        conn.state = CONN_DONE;
+    }
+
+    void flush(size_t index) {
+        ReplayConnection& conn = connections[index];
+        while (!conn.output.empty() && conn.state == CONN_OPEN) {
+            int result = send(conn.socket, conn.output.data(), static_cast<int>(conn.output.size()), MSG_NOSIGNAL);
+            if (result < 0) {
+                if (!socketWouldBlock()) {
+                    finish(index, true);
+                }
+                return;
+            }
+            conn.output.erase(0, static_cast<size_t>(result));
+            report.bytesSent += static_cast<uint64_t>(result);
+            lastTraffic = nowNanos();
+        }
+        if (conn.output.empty() && conn.closeWhenFlushed) {
+            finish(index, false);
+        }
+    }
+
+    void open(size_t index) {
+        ReplayConnection& conn = connections[index];
+        conn.socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (conn.socket == INVALID_SOCKET || setNonBlocking(conn.socket) == SOCKET_ERROR) {
+            std::cerr << "Cannot create socket (error " << lastSocketError() << "); raise the open file limit?\n";
+            finish(index, true);
+            return;
+        }
+        int noDelay = 1;
+        setsockopt(conn.socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+        if ((connect(conn.socket, (SOCKADDR*)&address, sizeof(address)) == SOCKET_ERROR && !connectInProgress()) ||
+            poller->add(conn.socket, POLLER_READ | POLLER_WRITE, index) != SUCCESS) {
+            finish(index, true);
+            return;
+        }
+        conn.state = CONN_CONNECTING;
+    }
+
+    void apply(const TraceEvent& event) {
+        ReplayConnection& conn = connections[event.connection];
+        switch (event.type) {
+        case LOG_CAPTURE_OPEN:
+            open(event.connection);
+            break;
+        case LOG_CAPTURE_DATA:
+            if (conn.state == CONN_DONE) {
+                break;
+            }
+            if (conn.waitingSince == 0) {
+                conn.waitingSince = nowNanos();
+            }
+            conn.output += event.data;
+            flush(event.connection);
+            break;
+        case LOG_CAPTURE_CLOSE:
+            conn.closeWhenFlushed = true;
+            if (conn.state == CONN_OPEN) {
+                flush(event.connection);
+            }
+            break;
+        }
+        if (conn.state == CONN_CONNECTING || (conn.state == CONN_OPEN && !poller->edgeTriggered())) {
+            updateInterest(event.connection);
+        }
+    }
+
+    void readConnection(size_t index) {
+        ReplayConnection& conn = connections[index];
+        char buffer[64 * 1024];
+        while (conn.state == CONN_OPEN) {
+            int result = recv(conn.socket, buffer, sizeof(buffer), 0);
+            if (result < 0 && socketWouldBlock()) {
+                return;
+            }
+            if (result <= 0) {
+                // The server may close first, e.g. after ~logout
+                finish(index, !conn.closeWhenFlushed && !conn.output.empty());
+                return;
+            }
+            uint64_t now = nowNanos();
+            report.bytesReceived += static_cast<uint64_t>(result);
+            lastTraffic = now;
+            if (conn.waitingSince != 0) {
+                report.response.record(now - conn.waitingSince);
+                conn.waitingSince = 0;
+            }
+        }
+    }
+
+    void handleEvents(int timeoutMs) {
+        if (poller->wait(readyEvents, timeoutMs) != SUCCESS) {
+            return;
+        }
+        for (const PollEvent& event : readyEvents) {
+            size_t index = static_cast<size_t>(event.token);
+            ReplayConnection& conn = connections[index];
+            if (conn.state == CONN_CONNECTING && (event.events & (POLLER_WRITE | POLLER_ERROR))) {
+                int error = 0;
+                socklen_t length = sizeof(error);
+                if (getsockopt(conn.socket, SOL_SOCKET, SO_ERROR, (char*)&error, &length) != 0 || error != 0) {
+                    finish(index, true);
+                    continue;
+                }
+                conn.state = CONN_OPEN;
+                flush(index);
+            }
+            else if (conn.state == CONN_OPEN && (event.events & POLLER_WRITE)) {
+                flush(index);
+            }
+            if (conn.state == CONN_OPEN && (event.events & (POLLER_READ | POLLER_ERROR))) {
+                readConnection(index);
+            }
+            if (conn.state != CONN_DONE && !poller->edgeTriggered()) {
+                updateInterest(index);
+            }
+        }
+    }
+
+    bool pendingOutput() const {
+        for (const ReplayConnection& conn : connections) {
+            if (conn.state != CONN_DONE && (conn.state == CONN_CONNECTING || !conn.output.empty())) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+    Replayer(const ReplayOptions& options, const Trace& trace)
+        : options(options), trace(trace), poller(createPoller(defaultPollerType())), address(), start(0), lastTraffic(0) {}
+
+    int run() {
+        address.sin_family = AF_INET;
+        address.sin_port = htons(options.port);
+        if (inet_pton(AF_INET, options.host.c_str(), &address.sin_addr) != 1) {
+            std::cerr << "Bad host address " << options.host << "\n";
+            return PARAMETER_ERROR;
+        }
+        connections.resize(trace.connections);
+
+        start = nowNanos();
+        lastTraffic = start;
+        size_t next = 0;
+        while (next < trace.events.size()) {
+            uint64_t elapsed = nowNanos() - start;
+            // Bounded bursts, so replies keep being read when the schedule falls behind
+            for (int burst = 0; next < trace.events.size() && burst < 256; burst++) {
+                const TraceEvent& event = trace.events[next];
+                uint64_t due = (options.speed > 0) ? static_cast<uint64_t>(static_cast<double>(event.at) / options.speed) : 0;
+                if (due > elapsed) {
+                    break;
+                }
+                if (options.speed > 0 && event.type == LOG_CAPTURE_DATA) {
+                    report.lateness.record(elapsed - due);
+                }
+                // At max speed a captured close would cut off the replies still
+                // on their way; connections are closed at the end instead
+                if (options.speed > 0 || event.type != LOG_CAPTURE_CLOSE) {
+                    apply(event);
+                }
+                next++;
+            }
+            handleEvents((next < trace.events.size() && options.speed > 0) ? 1 : 0);
+        }
+
+        // Let the last replies arrive
+        for (;;) {
+            handleEvents(10);
+            uint64_t quiet = nowNanos() - lastTraffic;
+            if (!pendingOutput() && quiet >= static_cast<uint64_t>(options.quietMs) * 1000000) {
+                break;
+            }
+            if (quiet >= 30ull * 1000000000) {
+                std::cerr << "Gave up waiting for the server to take the remaining input\n";
+                break;
+            }
+        }
+        report.elapsed = lastTraffic - start;
+        for (size_t i = 0; i < connections.size(); i++) {
+            finish(i, false);
+        }
+        return SUCCESS;
+    }
+
+    const ReplayReport& result() const { return report; }
+};
+
+// Figures a --save file holds and a --baseline is compared on, in order.
+typedef std::vector<std::pair<std::string, double>> ReplayFigures;
+
+static ReplayFigures figuresOf(const Trace& trace, const ReplayReport& report) {
+    double seconds = static_cast<double>(report.elapsed > 0 ? report.elapsed : 1) / 1e9;
+    return ReplayFigures{
+        { "seconds", seconds },
+        { "frames_per_second", static_cast<double>(trace.frames) / seconds },
+        { "bytes_received", static_cast<double>(report.bytesReceived) },
+        { "failures", static_cast<double>(report.failures) },
+        { "response_p50_us", static_cast<double>(report.response.percentile(0.50)) / 1000 },
+        { "response_p99_us", static_cast<double>(report.response.percentile(0.99)) / 1000 },
+        { "response_p999_us", static_cast<double>(report.response.percentile(0.999)) / 1000 },
+        { "response_max_us", static_cast<double>(report.response.maxRecorded()) / 1000 },
+        { "late_p99_us", static_cast<double>(report.lateness.percentile(0.99)) / 1000 },
+    };
+}
+
+static bool saveFigures(const std::string& path, const ReplayFigures& figures) {
+    std::ofstream out(path);
+    for (const auto& figure : figures) {
+        out << figure.first << " " << figure.second << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+static bool loadFigures(const std::string& path, ReplayFigures& figures) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    std::string name;
+    double value;
+    while (in >> name >> value) {
+        figures.emplace_back(name, value);
+    }
+    return true;
+}
+
+static void printComparison(const ReplayFigures& baseline, const ReplayFigures& current) {
+    std::cout << "Against the baseline:\n";
+    for (const auto& figure : current) {
+        for (const auto& base : baseline) {
+            if (base.first != figure.first) {
+                continue;
+            }
+            char line[160];
+            if (base.second != 0) {
+                snprintf(line, sizeof(line), "  %-18s %12.3f -> %12.3f (%+.1f%%)\n", figure.first.c_str(), base.second,
+                    figure.second, (figure.second - base.second) * 100 / base.second);
+            }
+            else {
+                snprintf(line, sizeof(line), "  %-18s %12.3f -> %12.3f\n", figure.first.c_str(), base.second, figure.second);
+            }
+            std::cout << line;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    ReplayOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--host=", 0) == 0) {
+            options.host = arg.substr(7);
+        }
+        else if (arg.rfind("--port=", 0) == 0) {
+            options.port = static_cast<uint16_t>(std::atoi(arg.c_str() + 7));
+        }
+        else if (arg == "--speed=max") {
+            options.speed = 0;
+        }
+        else if (arg.rfind("--speed=", 0) == 0) {
+            options.speed = std::atof(arg.c_str() + 8);
+            if (options.speed <= 0) {
+                std::cerr << "Bad --speed; use a factor such as 1 or 10, or max\n";
+                return 1;
+            }
+        }
+        else if (arg.rfind("--quiet=", 0) == 0) {
+            options.quietMs = std::atoi(arg.c_str() + 8);
+        }
+        else if (arg.rfind("--save=", 0) == 0) {
+            options.savePath = arg.substr(7);
+        }
+        else if (arg.rfind("--baseline=", 0) == 0) {
+            options.baselinePath = arg.substr(11);
+        }
+        else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown option " << arg << "\n";
+            return 1;
+        }
+        else {
+            options.traces.push_back(arg);
+        }
+    }
+    if (options.port == 0 || options.traces.empty()) {
+        std::cerr << "Usage: " << argv[0] << " --port=N [--host=ADDR] [--speed=1|N|max] [--quiet=MS]"
+            " [--save=FILE] [--baseline=FILE] <capture.rlog> [...]\n";
+        return 1;
+    }
+
+    ReplayFigures baseline;
+    if (!options.baselinePath.empty() && !loadFigures(options.baselinePath, baseline)) {
+        std::cerr << "Cannot read baseline " << options.baselinePath << "\n";
+        return 1;
+    }
+    Trace trace;
+    if (!loadTrace(options.traces, trace)) {
+        return 1;
+    }
+    if (trace.events.empty()) {
+        std::cerr << "No capture records found\n";
+        return 1;
+    }
+    if (initSockets() != 0) {
+        return 1;
+    }
+
+    std::cout << "Trace: " << trace.connections << " connections, " << trace.frames << " frames, " << trace.bytes
+        << " bytes over " << trace.events.back().at / 1000000 << " ms; playing at "
+        << (options.speed > 0 ? std::to_string(options.speed) + "x" : std::string("max speed")) << "\n";
+    Replayer replayer(options, trace);
+    if (replayer.run() != SUCCESS) {
+        cleanupSockets();
+        return 1;
+    }
+    const ReplayReport& report = replayer.result();
+    ReplayFigures figures = figuresOf(trace, report);
+    double seconds = figures[0].second;
+    std::cout << "Replayed in " << seconds << " s: " << static_cast<uint64_t>(trace.frames / seconds) << " frames/s, "
+        << report.bytesSent << " bytes sent, " << report.bytesReceived << " received, "
+        << report.failures << " connection(s) failed\n"
+        << "Response latency: ";
+    formatHistogram(std::cout, report.response, true);
+    if (options.speed > 0) {
+        std::cout << "\nBehind schedule: ";
+        formatHistogram(std::cout, report.lateness, true);
+    }
+    std::cout << "\n";
+
+    if (!baseline.empty()) {
+        printComparison(baseline, figures);
+    }
+    if (!options.savePath.empty() && !saveFigures(options.savePath, figures)) {
+        std::cerr << "Cannot write " << options.savePath << "\n";
+    }
+    cleanupSockets();
+    return 0;
+}
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "LogRecord.h"
+#include "LogSegments.h"
+#include "MpscRing.h"
+#include "Status.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+enum FsyncPolicy {
+    FSYNC_NEVER,        // Leave durability to the OS page cache
+    FSYNC_INTERVAL,     // At most once per second
+    FSYNC_ALWAYS        // After every group commit
+};
+
+struct LogOptions {
+    size_t ringCapacity;     // Records buffered before appends start dropping
+    size_t batchBytes;       // Commit early once this much is pending
+    int flushIntervalMs;     // Otherwise commit this long after the first pending record
+    FsyncPolicy fsync;
+    size_t segmentBytes;     // Start a new segment once the active one reaches this size
+    size_t indexInterval;    // Record bytes between sparse index entries
+
+    LogOptions() : ringCapacity(64 * 1024), batchBytes(64 * 1024), flushIntervalMs(10), fsync(FSYNC_NEVER),
+        segmentBytes(16 * 1024 * 1024), indexInterval(4096) {}
+};
+
+// Append-only binary log written by a background thread. Appends encode the
+// record and push it onto a lock-free ring, so the event loop never waits on
+// the disk; the writer drains the ring in group commits (one write, and
+// optionally one fsync, per batch) into size-capped segments and publishes
+// each commit to the catalog readers use.
+class AsyncLog {
+private:
+    LogOptions options;
+    std::string prefix;
+    LogCatalog segments;
+    std::unique_ptr<MpscRing<std::string>> ring;
+    std::atomic<size_t> pendingBytes;
+    std::mutex wakeMutex;                 // Only taken to wake or park the writer
+    std::condition_variable wakeup;
+    bool stopping;
+    std::thread writer;
+
+    // Active segment; owned by the writer thread once it is running
+    FILE* file;
+    FILE* indexFile;
+    uint32_t sequence;
+    uint64_t segmentSize;
+    uint64_t segmentFirstRecord;
+    uint64_t nextRecord;
+    uint64_t lastIndexOffset;
+
+public:
+    std::atomic<uint64_t> recordsWritten;
+    std::atomic<uint64_t> recordsDropped;   // Ring full: the writer could not keep up
+    std::atomic<uint64_t> commits;
+    std::atomic<uint64_t> syncs;
+    std::atomic<uint64_t> segmentsOpened;
+
+    AsyncLog() : pendingBytes(0), stopping(false), file(nullptr), indexFile(nullptr), sequence(0),
+        segmentSize(0), segmentFirstRecord(0), nextRecord(0), lastIndexOffset(0),
+        recordsWritten(0), recordsDropped(0), commits(0), syncs(0), segmentsOpened(0) {}
+
+    ~AsyncLog() {
+        close();
+    }
+
+    // Segments left by earlier runs stay readable; this run appends to a new one.
+    int open(const std::string& pathPrefix, const LogOptions& logOptions) {
+        options = logOptions;
+        prefix = pathPrefix;
+        uint64_t records = 0;
+        for (sequence = 1;; sequence++) {
+            LogSegment segment;
+            if (!loadLogSegment(prefix, sequence, records, options.indexInterval, segment)) {
+                break;
+            }
+            records += segment.recordCount;
+            if (segment.recordCount > 0) {
+                segments.addSegment(std::move(segment));
+            }
+        }
+        nextRecord = records;
+        if (!startSegment()) {
+            return SETUP_ERROR;
+        }
+        ring.reset(new MpscRing<std::string>(options.ringCapacity));
+        stopping = false;
+        writer = std::thread([this] { writerLoop(); });
+        return SUCCESS;
+    }
+
+    bool isOpen() const { return ring != nullptr; }
+
+    LogCatalog& catalog() { return segments; }
+
+    // Safe from any thread; never blocks on I/O. A zero timestamp means now.
+    void append(uint8_t type, std::string_view user, std::string_view payload, uint64_t timestamp = 0) {
+        if (!ring) {
+            return;
+        }
+        std::string record;
+        encodeLogRecord(record, timestamp ? timestamp : logTimestampNow(), type, user, payload);
+        // Counted before the push so the writer never drains bytes it has not seen added
+        size_t size = record.size();
+        size_t before = pendingBytes.fetch_add(size);
+        if (!ring->tryPush(std::move(record))) {
+            pendingBytes -= size;
+            recordsDropped++;
+            return;
+        }
+
+        // Wake the writer for the first pending record and when a full batch is ready
+        if (before == 0 || (before < options.batchBytes && before + size >= options.batchBytes)) {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            wakeup.notify_one();
+        }
+    }
+
+    // Commits everything appended so far, then stops the writer.
+    void close() {
+        if (writer.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex);
+                stopping = true;
+            }
+            wakeup.notify_one();
+            writer.join();
+        }
+        closeSegment();
+        ring.reset();
+    }
+
+private:
+    bool startSegment() {
+        // Never reuse a number; a gap left by a deleted segment must not truncate a later one
+        while (logFileExists(logSegmentPath(prefix, sequence, LOG_SEGMENT_EXTENSION))) {
+            sequence++;
+        }
+        LogSegment segment;
+        segment.sequence = sequence;
+        segment.path = logSegmentPath(prefix, sequence, LOG_SEGMENT_EXTENSION);
+        segment.firstRecord = nextRecord;
+        segment.bytes = sizeof(LOG_FILE_MAGIC);
+
+        file = fopen(segment.path.c_str(), "wb");
+        indexFile = fopen(logSegmentPath(prefix, sequence, LOG_INDEX_EXTENSION).c_str(), "wb");
+        if (!file || !indexFile) {
+            closeSegment();
+            return false;
+        }
+        fwrite(LOG_FILE_MAGIC, 1, sizeof(LOG_FILE_MAGIC), file);
+        fflush(file);
+
+        segmentSize = segment.bytes;
+        segmentFirstRecord = nextRecord;
+        lastIndexOffset = 0;
+        segments.addSegment(std::move(segment));
+        segmentsOpened++;
+        return true;
+    }
+
+    void closeSegment() {
+        if (file) {
+            fclose(file);
+            file = nullptr;
+        }
+        if (indexFile) {
+            fclose(indexFile);
+            indexFile = nullptr;
+        }
+    }
+
+    void writerLoop() {
+        std::string batch;
+        std::string record;
+        std::vector<LogIndexEntry> entries;
+        auto lastSync = std::chrono::steady_clock::now();
+
+        for (;;) {
+            bool finishing;
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                wakeup.wait(lock, [this] { return stopping || pendingBytes.load() > 0; });
+                // Group commit: give other appends until the interval (or a full batch) to join
+                wakeup.wait_for(lock, std::chrono::milliseconds(options.flushIntervalMs),
+                    [this] { return stopping || pendingBytes.load() >= options.batchBytes; });
+                finishing = stopping;
+            }
+
+            size_t drained = 0;
+            uint64_t count = 0;
+            while (ring->tryPop(record)) {
+                drained += record.size();
+                uint64_t offset = segmentSize + batch.size();
+                if (nextRecord + count == segmentFirstRecord || offset >= lastIndexOffset + options.indexInterval) {
+                    LogEntry entry = {};
+                    decodeLogRecord(record.data(), record.size(), entry);
+                    entries.push_back(LogIndexEntry{ nextRecord + count, entry.timestampMicros, offset });
+                    lastIndexOffset = offset;
+                }
+                batch += record;
+                count++;
+            }
+            pendingBytes -= drained;
+
+            if (!batch.empty()) {
+                commit(batch, count, entries);
+                batch.clear();
+                entries.clear();
+
+                auto now = std::chrono::steady_clock::now();
+                if (file && (options.fsync == FSYNC_ALWAYS ||
+                    (options.fsync == FSYNC_INTERVAL && now - lastSync >= std::chrono::seconds(1)))) {
+                    syncToDisk();
+                    lastSync = now;
+                }
+                if (file && segmentSize >= options.segmentBytes) {
+                    rotate();
+                }
+            }
+
+            if (finishing && pendingBytes.load() == 0) {
+                if (file && options.fsync != FSYNC_NEVER) {
+                    syncToDisk();
+                }
+                return;
+            }
+        }
+    }
+
+    void commit(const std::string& batch, uint64_t count, const std::vector<LogIndexEntry>& entries) {
+        if (!file) {
+            recordsDropped += count;
+            return;
+        }
+        fwrite(batch.data(), 1, batch.size(), file);
+        fflush(file);
+        if (!entries.empty()) {
+            std::string encoded;
+            for (const LogIndexEntry& entry : entries) {
+                encodeIndexEntry(encoded, entry, segmentFirstRecord);
+            }
+            fwrite(encoded.data(), 1, encoded.size(), indexFile);
+            fflush(indexFile);
+        }
+        // Published only once flushed, so readers never map bytes the file lacks
+        segments.commit(count, batch.size(), entries);
+        segmentSize += batch.size();
+        nextRecord += count;
+        recordsWritten += count;
+        commits++;
+    }
+
+    void rotate() {
+        if (options.fsync != FSYNC_NEVER) {
+            syncToDisk();
+        }
+        closeSegment();
+        sequence++;
+        startSegment();   // On failure later commits are counted as dropped
+    }
+
+    void syncToDisk() {
+#ifdef _WIN32
+        _commit(_fileno(file));
+#else
+        fsync(fileno(file));
+#endif
+        syncs++;
+    }
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Size-classed blocks for one reactor's receive buffers. Blocks are carved
+// from large slabs and recycled through per-class free lists threaded through
+// the free blocks themselves, so taking or returning one is a pointer swap
+// and never touches the allocator or zeroes memory. Slabs are kept for the
+// life of the reactor: the pool grows to the peak number of connections with
+// a partial frame pending, not the number connected. Single-threaded; only
+// the counters may be read from other threads.
+class BufferPool {
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    static const size_t SLAB_BYTES = 256 * 1024;
+
+    FreeBlock* freeLists[4];
+    std::vector<std::unique_ptr<char[]>> slabs;
+
+    void carve(int sizeClass) {
+        size_t size = classSize(sizeClass);
+        size_t count = (SLAB_BYTES / size > 4) ? SLAB_BYTES / size : 4;
+        std::unique_ptr<char[]> slab(new char[size * count]);
+        for (size_t i = 0; i < count; i++) {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(slab.get() + i * size);
+            block->next = freeLists[sizeClass];
+            freeLists[sizeClass] = block;
+        }
+        slabs.push_back(std::move(slab));
+        slabBytes += size * count;
+    }
+
+public:
+    static const int CLASSES = 4;
+
+    std::atomic<size_t> blocksInUse;
+    std::atomic<size_t> slabBytes;
+
+    BufferPool() : blocksInUse(0), slabBytes(0) {
+        for (FreeBlock*& head : freeLists) {
+            head = nullptr;
+        }
+    }
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // 1, 4 and 16 KiB, then one large enough for the biggest v2 frame.
+    static size_t classSize(int sizeClass) {
+        static const size_t sizes[CLASSES] = { 1024, 4096, 16 * 1024, 65 * 1024 };
+        return sizes[sizeClass];
+    }
+
+    static size_t largestBlock() { return classSize(CLASSES - 1); }
+
+    // Smallest class holding size bytes; -1 past the largest.
+    static int classFor(size_t size) {
+        for (int sizeClass = 0; sizeClass < CLASSES; sizeClass++) {
+            if (size <= classSize(sizeClass)) {
+                return sizeClass;
+            }
+        }
+        return -1;
+    }
+
+    char* allocate(int sizeClass) {
+        if (!freeLists[sizeClass]) {
+            carve(sizeClass);
+        }
+        FreeBlock* block = freeLists[sizeClass];
+        freeLists[sizeClass] = block->next;
+        blocksInUse++;
+        return reinterpret_cast<char*>(block);
+    }
+
+    void release(char* data, int sizeClass) {
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(data);
+        block->next = freeLists[sizeClass];
+        freeLists[sizeClass] = block;
+        blocksInUse--;
+    }
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "PasswordHash.h"
+#include "SlotMap.h"
+#include "Status.h"
+
+// Where a logged-in user's connection lives.
+struct UserLocation {
+    int reactorId;
+    SlotHandle connection;   // Handle in the owning reactor's connection table
+};
+
+// Accounts and presence shared by every reactor thread. Users are spread over
+// independently locked shards so logins on different reactors rarely contend.
+class ChatDirectory {
+private:
+    struct User {
+        Credential credential;   // Salted hash; the password itself is never kept
+        bool isLoggedIn;
+        UserLocation location;
+
+        User(const Credential& credential)
+            : credential(credential), isLoggedIn(false), location{ -1, INVALID_HANDLE } {}
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, User> users;  // Username -> User mapping
+    };
+
+    static const size_t SHARD_COUNT = 64;
+    Shard shards[SHARD_COUNT];
+    std::atomic<size_t> userCount;
+
+    Shard& shardFor(const std::string& username) {
+        return shards[std::hash<std::string>()(username) % SHARD_COUNT];
+    }
+
+public:
+    ChatDirectory() : userCount(0) {}
+
+    size_t size() const { return userCount.load(); }
+
+    // Sizes the shards ahead of a bulk load.
+    void reserve(size_t users) {
+        for (Shard& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.users.reserve(users / SHARD_COUNT + 1);
+        }
+    }
+
+    bool exists(const std::string& username) {
+        Shard& shard = shardFor(username);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.users.find(username) != shard.users.end();
+    }
+
+    int registerUser(const std::string& username, const Credential& credential) {
+        Shard& shard = shardFor(username);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        if (!shard.users.emplace(username, User(credential)).second) {
+            return EXISTS_ERROR;
+        }
+        userCount++;
+        return SUCCESS;
+    }
+
+    // Copied out so the caller can verify a password without holding a shard lock.
+    bool credentialFor(const std::string& username, Credential& credential) {
+        Shard& shard = shardFor(username);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto userIt = shard.users.find(username);
+        if (userIt == shard.users.end()) {
+            return false;
+        }
+        credential = userIt->second.credential;
+        return true;
+    }
+
+    // Marks an already authenticated user online.
+    int login(const std::string& username, const UserLocation& location) {
+        Shard& shard = shardFor(username);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto userIt = shard.users.find(username);
+        if (userIt == shard.users.end()) {
+            return NOT_FOUND;
+        }
+        if (userIt->second.isLoggedIn) {
+            return LOGIN_CONFLICT;
+        }
+
+        userIt->second.isLoggedIn = true;
+        userIt->second.location = location;
+        return SUCCESS;
+    }
+
+    void logout(const std::string& username) {
+        Shard& shard = shardFor(username);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto userIt = shard.users.find(username);
+        if (userIt != shard.users.end()) {
+            userIt->second.isLoggedIn = false;
+            userIt->second.location = { -1, INVALID_HANDLE };
+        }
+    }
+
+    bool locate(const std::string& username, UserLocation& location) {
+        Shard& shard = shardFor(username);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto userIt = shard.users.find(username);
+        if (userIt == shard.users.end() || !userIt->second.isLoggedIn) {
+            return false;
+        }
+        location = userIt->second.location;
+        return true;
+    }
+
+    std::vector<std::string> onlineUsers() {
+        std::vector<std::string> result;
+        for (Shard& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (const auto& entry : shard.users) {
+                if (entry.second.isLoggedIn) {
+                    result.push_back(entry.first);
+                }
+            }
+        }
+        return result;
+    }
+};
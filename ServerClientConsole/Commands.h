@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Splits a command line into whitespace-separated words without copying;
+// every token is a view into the received frame.
+class Tokenizer {
+private:
+    std::string_view rest;
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    void skipSpaces() {
+        size_t i = 0;
+        while (i < rest.size() && isSpace(rest[i])) i++;
+        rest.remove_prefix(i);
+    }
+
+public:
+    explicit Tokenizer(std::string_view text) : rest(text) {}
+
+    // Empty once the input is exhausted.
+    std::string_view next() {
+        skipSpaces();
+        size_t end = 0;
+        while (end < rest.size() && !isSpace(rest[end])) end++;
+        std::string_view token = rest.substr(0, end);
+        rest.remove_prefix(end);
+        return token;
+    }
+
+    // Everything after the words consumed so far, minus leading whitespace.
+    std::string_view remainder() {
+        skipSpaces();
+        return rest;
+    }
+};
+
+enum CommandId {
+    CMD_UNKNOWN,
+    CMD_HELP,
+    CMD_REGISTER,
+    CMD_LOGIN,
+    CMD_LOGOUT,
+    CMD_SEND,
+    CMD_JOIN,
+    CMD_PART,
+    CMD_MSG,
+    CMD_GETLIST,
+    CMD_PRESENCE,
+    CMD_GETLOG,
+    CMD_STATS,
+    CMD_QUEUES,
+    CMD_COUNT   // Size of arrays indexed by CommandId
+};
+
+enum CommandAccess {
+    ACCESS_ANYONE,
+    ACCESS_USER,    // Logged in
+    ACCESS_ADMIN    // Logged in as one of the configured admins
+};
+
+struct CommandSpec {
+    CommandId id;
+    const char* name;
+    CommandAccess access;
+    bool blocking;        // Runs on the command executor, off the event loop
+    const char* description;
+};
+
+// Listed in ~help order. Adding a command means a row here, a case in
+// lookupCommand and a case in the server's dispatch switch (runBlockingCommand
+// for blocking ones).
+constexpr CommandSpec COMMAND_TABLE[] = {
+    { CMD_HELP, "help", ACCESS_ANYONE, false, "Display all available commands" },
+    { CMD_REGISTER, "register", ACCESS_ANYONE, false, "Register a new user account (usage: ~register username password)" },
+    { CMD_LOGIN, "login", ACCESS_ANYONE, false, "Log in with registered credentials (usage: ~login username password [last-seen-seq])" },
+    { CMD_LOGOUT, "logout", ACCESS_ANYONE, false, "Log out and disconnect" },
+    { CMD_SEND, "send", ACCESS_USER, false, "Send a private message (usage: ~send username message)" },
+    { CMD_JOIN, "join", ACCESS_USER, false, "Join a room, creating it if needed (usage: ~join #room)" },
+    { CMD_PART, "part", ACCESS_USER, false, "Leave a room (usage: ~part #room)" },
+    { CMD_MSG, "msg", ACCESS_USER, false, "Send a message to a room you are in (usage: ~msg #room message)" },
+    { CMD_GETLIST, "getlist", ACCESS_USER, false, "List users currently online, a page at a time (usage: ~getlist [prefix] [after name])" },
+    { CMD_PRESENCE, "presence", ACCESS_USER, false, "Get a notice whenever users come online or leave (usage: ~presence on|off)" },
+    { CMD_GETLOG, "getlog", ACCESS_ANYONE, true, "Show recent public messages (usage: ~getlog [tail N | page N | since TIME])" },
+    { CMD_STATS, "stats", ACCESS_ADMIN, false, "Show server statistics and latency histograms (admins only)" },
+    { CMD_QUEUES, "queues", ACCESS_ADMIN, false, "Show per-client output queue depth and drops (admins only)" }
+};
+
+constexpr uint32_t commandHash(std::string_view name) {
+    uint32_t hash = 2166136261u;  // FNV-1a
+    for (char c : name) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+// Case labels are computed at compile time, so a hash collision between two
+// command names fails the build instead of misrouting at runtime.
+constexpr CommandId lookupCommand(std::string_view name) {
+    CommandId id = CMD_UNKNOWN;
+    switch (commandHash(name)) {
+    case commandHash("help"): id = CMD_HELP; break;
+    case commandHash("register"): id = CMD_REGISTER; break;
+    case commandHash("login"): id = CMD_LOGIN; break;
+    case commandHash("logout"): id = CMD_LOGOUT; break;
+    case commandHash("send"): id = CMD_SEND; break;
+    case commandHash("join"): id = CMD_JOIN; break;
+    case commandHash("part"): id = CMD_PART; break;
+    case commandHash("msg"): id = CMD_MSG; break;
+    case commandHash("getlist"): id = CMD_GETLIST; break;
+    case commandHash("presence"): id = CMD_PRESENCE; break;
+    case commandHash("getlog"): id = CMD_GETLOG; break;
+    case commandHash("stats"): id = CMD_STATS; break;
+    case commandHash("queues"): id = CMD_QUEUES; break;
+    default: return CMD_UNKNOWN;
+    }
+    // One compare confirms the match; anything else merely shares a hash
+    return (name == COMMAND_TABLE[id - 1].name) ? id : CMD_UNKNOWN;
+}
+
+constexpr bool commandTableInOrder() {
+    for (size_t i = 0; i < sizeof(COMMAND_TABLE) / sizeof(COMMAND_TABLE[0]); i++) {
+        if (COMMAND_TABLE[i].id != static_cast<CommandId>(i + 1) || lookupCommand(COMMAND_TABLE[i].name) != COMMAND_TABLE[i].id) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(commandTableInOrder(), "COMMAND_TABLE rows must follow CommandId order");
+
+// The part of a command line that may be written to the command log:
+// passwords stay out, so register and login keep the username only.
+inline std::string_view loggableCommand(CommandId id, std::string_view command) {
+    if (id != CMD_REGISTER && id != CMD_LOGIN) {
+        return command;
+    }
+    Tokenizer words(command);
+    words.next();
+    std::string_view user = words.next();
+    return command.substr(0, static_cast<size_t>(user.data() + user.size() - command.data()));
+}
+static_assert(lookupCommand("get") == CMD_UNKNOWN, "prefixes must not match");
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+// Compression is negotiated per v2 connection: the client sends a
+// FRAME_COMPRESS listing the codecs it can inflate (space separated) and the
+// server answers with a FRAME_COMPRESS naming the one it will use, or empty
+// for none. From then on the server may send FRAME_DEFLATE frames.
+#define CODEC_DEFLATE "deflate"
+
+// Raw deflate (RFC 1951) in one direction of one connection, keeping the
+// window across frames (context takeover): a reply compresses against the
+// text already sent. Each compress() ends in a sync flush, so every
+// FRAME_DEFLATE inflates on its own into whole v2 frames. Builds without
+// zlib (no HAVE_ZLIB) never negotiate it.
+class DeflateStream {
+private:
+#ifdef HAVE_ZLIB
+    z_stream stream;   // Points into itself; the stream is never moved or copied
+#endif
+    bool ready;
+
+    DeflateStream(const DeflateStream&) = delete;
+    DeflateStream& operator=(const DeflateStream&) = delete;
+
+public:
+    // A 4 KiB window with memLevel 5 keeps the state near 32 KiB per
+    // connection; chat text gains little from a larger one.
+    static const int WINDOW_BITS = 12;
+    static const int MEM_LEVEL = 5;
+
+    static bool supported() {
+#ifdef HAVE_ZLIB
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    DeflateStream() : ready(false) {}
+
+    ~DeflateStream() {
+#ifdef HAVE_ZLIB
+        if (ready) {
+            deflateEnd(&stream);
+        }
+#endif
+    }
+
+    bool init(int level) {
+#ifdef HAVE_ZLIB
+        memset(&stream, 0, sizeof(stream));
+        ready = deflateInit2(&stream, level, Z_DEFLATED, -WINDOW_BITS, MEM_LEVEL, Z_DEFAULT_STRATEGY) == Z_OK;
+#else
+        (void)level;
+#endif
+        return ready;
+    }
+
+    // Appends the compressed bytes to out. On failure out is left as it was
+    // and the stream must not be used again.
+    bool compress(const char* data, size_t length, std::string& out) {
+#ifdef HAVE_ZLIB
+        if (!ready) {
+            return false;
+        }
+        size_t start = out.size();
+        size_t used = start;
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        stream.avail_in = static_cast<uInt>(length);
+        do {
+            out.resize(used + length / 2 + 64);
+            stream.next_out = reinterpret_cast<Bytef*>(&out[used]);
+            stream.avail_out = static_cast<uInt>(out.size() - used);
+            int result = deflate(&stream, Z_SYNC_FLUSH);
+            if (result != Z_OK && result != Z_BUF_ERROR) {
+                out.resize(start);
+                return false;
+            }
+            used = out.size() - stream.avail_out;
+        } while (stream.avail_out == 0);
+        out.resize(used);
+        return true;
+#else
+        (void)data;
+        (void)length;
+        (void)out;
+        return false;
+#endif
+    }
+};
+
+// The receiving end, for clients and tools.
+class InflateStream {
+private:
+#ifdef HAVE_ZLIB
+    z_stream stream;
+#endif
+    bool ready;
+
+    InflateStream(const InflateStream&) = delete;
+    InflateStream& operator=(const InflateStream&) = delete;
+
+public:
+    InflateStream() : ready(false) {}
+
+    ~InflateStream() {
+#ifdef HAVE_ZLIB
+        if (ready) {
+            inflateEnd(&stream);
+        }
+#endif
+    }
+
+    bool init() {
+#ifdef HAVE_ZLIB
+        memset(&stream, 0, sizeof(stream));
+        ready = inflateInit2(&stream, -15) == Z_OK;   // Any window the sender picked
+#endif
+        return ready;
+    }
+
+    // Appends what one FRAME_DEFLATE payload inflates to.
+    bool decompress(const char* data, size_t length, std::string& out) {
+#ifdef HAVE_ZLIB
+        if (!ready) {
+            return false;
+        }
+        size_t used = out.size();
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        stream.avail_in = static_cast<uInt>(length);
+        do {
+            out.resize(used + length * 4 + 256);
+            stream.next_out = reinterpret_cast<Bytef*>(&out[used]);
+            stream.avail_out = static_cast<uInt>(out.size() - used);
+            int result = inflate(&stream, Z_SYNC_FLUSH);
+            used = out.size() - stream.avail_out;
+            if (result != Z_OK && result != Z_BUF_ERROR) {
+                out.resize(used);
+                return false;
+            }
+        } while (stream.avail_out == 0);
+        out.resize(used);
+        return true;
+#else
+        (void)data;
+        (void)length;
+        (void)out;
+        return false;
+#endif
+    }
+};
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "FrameCodec.h"
+#include "PasswordHash.h"
+
+// Server-to-server links. Nodes listen on a peer port (loopback unless told
+// otherwise) and dial the peers they are told about; a link speaks v2 from
+// the first byte. Only addresses of configured peers may connect, and both
+// ends prove they hold the shared --peer-secret before anything else is
+// accepted: each opens with FRAME_PEER_HELLO naming its node and a random
+// challenge, and answers the other's challenge with FRAME_PEER_AUTH, an
+// HMAC-SHA256 under the secret of that challenge and its own node name (so a
+// proof cannot be reflected back at its sender). Every later frame names the
+// node it started from (its origin), so a node can relay what it hears to its
+// other links and still drop what comes back round a loop:
+//   presence and accounts are state ("alice is on node B"), relayed only when
+//   they change something, which ends the flood by itself;
+//   public messages carry the origin's run epoch and sequence and pass a
+//   ReplayWindow per origin;
+//   private messages are routed, not flooded, towards the node the recipient
+//   is on, with a hop limit as a backstop.
+// Frames for a link are collected during a loop iteration and written as one
+// FRAME_BATCH.
+//
+// Payloads, with "str" a varint length and bytes:
+//   PEER_HELLO     str node, str challenge
+//   PEER_AUTH      32-byte proof
+//   PEER_PRESENCE  str origin, u8 online, str user (empty: origin withdrawn)
+//   PEER_CHAT      str origin, varint epoch, varint sequence, str user, text
+//   PEER_PRIVATE   str destination, u8 hops, str from, str to, text
+//   PEER_ACCOUNT   str origin, user store record (see UserStore.h)
+
+static const uint8_t PEER_MAX_HOPS = 16;
+static const size_t PEER_CHALLENGE_SIZE = 16;
+
+inline std::string makePeerChallenge() {
+    std::random_device random;
+    std::string challenge;
+    while (challenge.size() < PEER_CHALLENGE_SIZE) {
+        uint32_t value = random();
+        challenge.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    return challenge;
+}
+
+// What the node answers a challenge with.
+inline std::string peerProof(const std::string& secret, std::string_view challenge, std::string_view node) {
+    std::string data(challenge);
+    appendVarint(data, node.size());
+    data.append(node.data(), node.size());
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    hmacSha256(reinterpret_cast<const uint8_t*>(secret.data()), secret.size(),
+        reinterpret_cast<const uint8_t*>(data.data()), data.size(), digest);
+    return std::string(reinterpret_cast<const char*>(digest), sizeof(digest));
+}
+
+// Constant time, like verifyPassword.
+inline bool peerProofMatches(std::string_view expected, std::string_view offered) {
+    if (expected.size() != offered.size()) {
+        return false;
+    }
+    uint8_t difference = 0;
+    for (size_t i = 0; i < expected.size(); i++) {
+        difference |= static_cast<uint8_t>(expected[i] ^ offered[i]);
+    }
+    return difference == 0;
+}
+
+inline void appendPeerString(std::string& out, std::string_view text) {
+    appendVarint(out, text.size());
+    out.append(text.data(), text.size());
+}
+
+// Reads the fields of a peer frame in order. Any short or malformed field
+// fails this and every later read, so callers check once at the end.
+class PeerReader {
+private:
+    const char* data;
+    size_t remaining;
+    bool failed;
+
+public:
+    PeerReader(const char* payload, size_t length) : data(payload), remaining(length), failed(false) {}
+
+    bool ok() const { return !failed; }
+
+    uint64_t number() {
+        uint64_t value = 0;
+        size_t used;
+        if (failed || decodeVarint(data, remaining, value, used) != DECODE_OK) {
+            failed = true;
+            return 0;
+        }
+        data += used;
+        remaining -= used;
+        return value;
+    }
+
+    uint8_t byte() {
+        if (failed || remaining < 1) {
+            failed = true;
+            return 0;
+        }
+        remaining--;
+        return static_cast<uint8_t>(*data++);
+    }
+
+    std::string_view string() {
+        uint64_t length = number();
+        if (failed || length > remaining) {
+            failed = true;
+            return std::string_view();
+        }
+        std::string_view text(data, static_cast<size_t>(length));
+        data += length;
+        remaining -= static_cast<size_t>(length);
+        return text;
+    }
+
+    std::string_view rest() {
+        std::string_view text(data, failed ? 0 : remaining);
+        remaining = 0;
+        return text;
+    }
+};
+
+// "host:port" from --peer=.
+struct PeerAddress {
+    std::string host;
+    uint16_t port;
+
+    static bool parse(const std::string& text, PeerAddress& address) {
+        size_t colon = text.rfind(':');
+        if (colon == std::string::npos || colon == 0) {
+            return false;
+        }
+        long port = std::strtol(text.c_str() + colon + 1, nullptr, 10);
+        if (port <= 0 || port > 65535) {
+            return false;
+        }
+        address.host = text.substr(0, colon);
+        address.port = static_cast<uint16_t>(port);
+        return true;
+    }
+};
+
+// Which public messages of one origin were already seen: the highest
+// sequence and a bitmap of the 64 before it, so copies arriving over a second
+// path, even slightly out of order, are recognised in O(1). A new epoch (the
+// origin restarted) starts the window over; an older one is stale.
+class ReplayWindow {
+private:
+    uint64_t epoch;
+    uint64_t highest;
+    uint64_t seen;   // Bit i: highest - i was seen
+
+public:
+    ReplayWindow() : epoch(0), highest(0), seen(0) {}
+
+    // True the first time a message is offered.
+    bool accept(uint64_t messageEpoch, uint64_t sequence) {
+        if (messageEpoch < epoch) {
+            return false;
+        }
+        if (messageEpoch > epoch) {
+            epoch = messageEpoch;
+            highest = sequence;
+            seen = 1;
+            return true;
+        }
+        if (sequence > highest) {
+            uint64_t shift = sequence - highest;
+            seen = (shift >= 64) ? 1 : (seen << shift) | 1;
+            highest = sequence;
+            return true;
+        }
+        uint64_t age = highest - sequence;
+        if (age >= 64 || (seen & (1ull << age)) != 0) {
+            return false;   // Too old to tell apart from a replay, or a copy
+        }
+        seen |= 1ull << age;
+        return true;
+    }
+};
+
+// Users logged in on other nodes, as announced over the links. Written by
+// the reactor that owns the links, read by every reactor (~send, logins).
+class PeerDirectory {
+private:
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, std::string> users;   // Username -> node
+
+public:
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return users.size();
+    }
+
+    bool locate(const std::string& username, std::string& node) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = users.find(username);
+        if (it == users.end()) {
+            return false;
+        }
+        node = it->second;
+        return true;
+    }
+
+    // Both return whether anything changed: unchanged state is not relayed.
+    bool online(const std::string& username, const std::string& node) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto result = users.emplace(username, node);
+        if (!result.second) {
+            if (result.first->second == node) {
+                return false;
+            }
+            result.first->second = node;
+        }
+        return true;
+    }
+
+    bool offline(const std::string& username, const std::string& node) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = users.find(username);
+        if (it == users.end() || it->second != node) {
+            return false;   // Already gone, or since seen logging in elsewhere
+        }
+        users.erase(it);
+        return true;
+    }
+
+    // Forgets every user of the node (its link went down); returns their names.
+    std::vector<std::string> dropNode(const std::string& node) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<std::string> dropped;
+        for (auto it = users.begin(); it != users.end();) {
+            if (it->second == node) {
+                dropped.push_back(it->first);
+                it = users.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+        return dropped;
+    }
+
+    // (username, node) pairs, for greeting a new link.
+    std::vector<std::pair<std::string, std::string>> snapshot() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return std::vector<std::pair<std::string, std::string>>(users.begin(), users.end());
+    }
+};
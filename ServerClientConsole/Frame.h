@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "FrameCodec.h"
+
+class Frame;
+typedef std::shared_ptr<const Frame> FramePtr;
+
+// Immutable, refcounted wire frame. Headers and payload are stored
+// contiguously so each recipient needs a single write, and a broadcast is
+// encoded once per protocol no matter how many connections (or reactors) it reaches.
+class Frame {
+private:
+    std::string encoded[2];  // v1 and v2 wire bytes; empty unless requested
+
+    Frame() {}
+
+public:
+    // Encoding for one protocol, e.g. a reply to a single connection.
+    static FramePtr create(const char* data, size_t length, int protocol) {
+        std::shared_ptr<Frame> frame(new Frame());
+        if (protocol == PROTOCOL_V1) {
+            frame->encoded[0].reserve(encodedSizeV1(length));
+            encodeV1(frame->encoded[0], data, length);
+        }
+        else {
+            frame->encoded[1].reserve(encodedSizeV2(length));
+            encodeV2(frame->encoded[1], FRAME_TEXT, data, length);
+        }
+        return frame;
+    }
+
+    // Encodings for every protocol, for broadcasts that reach mixed clients.
+    static FramePtr createAll(const char* data, size_t length) {
+        std::shared_ptr<Frame> frame(new Frame());
+        frame->encoded[0].reserve(encodedSizeV1(length));
+        encodeV1(frame->encoded[0], data, length);
+        frame->encoded[1].reserve(encodedSizeV2(length));
+        encodeV2(frame->encoded[1], FRAME_TEXT, data, length);
+        return frame;
+    }
+
+    // A public message for every protocol; v2 carries its history sequence number.
+    static FramePtr createChat(uint64_t sequence, const char* data, size_t length) {
+        std::shared_ptr<Frame> frame(new Frame());
+        frame->encoded[0].reserve(encodedSizeV1(length));
+        encodeV1(frame->encoded[0], data, length);
+        frame->encoded[1].reserve(encodedSizeChatV2(sequence, length));
+        encodeChatV2(frame->encoded[1], sequence, data, length);
+        return frame;
+    }
+
+    // Bytes that are already encoded (hello, batches).
+    static FramePtr wrap(std::string bytes, int protocol) {
+        std::shared_ptr<Frame> frame(new Frame());
+        frame->encoded[protocol - 1] = std::move(bytes);
+        return frame;
+    }
+
+    const char* data(int protocol) const { return encoded[protocol - 1].data(); }
+    size_t size(int protocol) const { return encoded[protocol - 1].size(); }
+
+    // Multi-line reply: v2 packs the lines into as few batch frames as fit,
+    // v1 gets one text frame per line. Empty lines are skipped.
+    static void createLines(const std::vector<std::string>& lines, int protocol, std::vector<FramePtr>& frames) {
+        if (protocol == PROTOCOL_V1) {
+            for (const std::string& line : lines) {
+                if (!line.empty()) {
+                    frames.push_back(create(line.data(), line.length(), PROTOCOL_V1));
+                }
+            }
+            return;
+        }
+        BatchBuilder batch;
+        for (const std::string& line : lines) {
+            if (line.empty() || batch.add(FRAME_TEXT, line.data(), line.length())) {
+                continue;
+            }
+            if (!batch.empty()) {
+                std::string bytes;
+                batch.finish(bytes);
+                frames.push_back(wrap(std::move(bytes), PROTOCOL_V2));
+            }
+            batch.add(FRAME_TEXT, line.data(), line.length());
+        }
+        if (!batch.empty()) {
+            std::string bytes;
+            batch.finish(bytes);
+            frames.push_back(wrap(std::move(bytes), PROTOCOL_V2));
+        }
+    }
+};
+
+// Broadcast accounting: frames encoded versus per-recipient deliveries.
+struct FanoutCounters {
+    std::atomic<uint64_t> framesEncoded;
+    std::atomic<uint64_t> deliveries;
+    std::atomic<uint64_t> bytesDelivered;
+
+    FanoutCounters() : framesEncoded(0), deliveries(0), bytesDelivered(0) {}
+};
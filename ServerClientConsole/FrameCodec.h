@@ -0,0 +1,271 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Wire framing for both protocol versions. Pure functions over byte ranges so
+// the codec can be exercised and benchmarked without sockets.
+//
+// v1: [uint8 length][payload]                       (payload <= 255 bytes)
+// v2: [varint length][uint8 type][payload]          (length covers type + payload)
+//
+// A connection starts in v1. A client upgrades by sending the hello
+// [0x00 'R' 'L' version]; a zero length byte is never a valid v1 frame. The
+// server answers with the same hello carrying the accepted version; frames
+// before it (the welcome) are v1, every later frame uses the accepted version.
+
+#define PROTOCOL_V1 1
+#define PROTOCOL_V2 2
+
+#define FRAME_TEXT 1     // UTF-8 chat text or command
+#define FRAME_BATCH 2    // Payload is a sequence of v2 frames (not nested)
+#define FRAME_CHAT 3     // Public message: [varint history sequence][text]
+#define FRAME_PING 4     // Liveness probe, either direction; answered with a pong
+#define FRAME_PONG 5     // Reply to a ping, payload echoed
+#define FRAME_COMPRESS 6 // Compression negotiation: codec names (see Compression.h)
+#define FRAME_DEFLATE 7  // Deflate stream chunk; inflates to whole v2 frames
+
+// Server-to-server links only (see Federation.h)
+#define FRAME_PEER_HELLO 8
+#define FRAME_PEER_PRESENCE 9
+#define FRAME_PEER_CHAT 10
+#define FRAME_PEER_PRIVATE 11
+#define FRAME_PEER_ACCOUNT 12
+#define FRAME_PEER_AUTH 13
+
+static const size_t V1_MAX_PAYLOAD = 255;
+static const size_t V2_MAX_PAYLOAD = 64 * 1024;
+static const size_t HELLO_SIZE = 4;
+static const size_t VARINT_MAX_BYTES = 10;
+
+enum DecodeResult {
+    DECODE_OK,
+    DECODE_NEED_MORE,
+    DECODE_ERROR
+};
+
+struct DecodedFrame {
+    uint8_t type;
+    const char* payload;
+    size_t length;      // Payload bytes
+    size_t frameSize;   // Header + payload bytes consumed from the input
+};
+
+inline void appendVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+inline size_t varintSize(uint64_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+inline DecodeResult decodeVarint(const char* data, size_t available, uint64_t& value, size_t& used) {
+    value = 0;
+    for (size_t i = 0; i < available && i < VARINT_MAX_BYTES; i++) {
+        uint8_t byte = static_cast<uint8_t>(data[i]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+        if ((byte & 0x80) == 0) {
+            used = i + 1;
+            return DECODE_OK;
+        }
+    }
+    return (available >= VARINT_MAX_BYTES) ? DECODE_ERROR : DECODE_NEED_MORE;
+}
+
+inline void encodeHello(std::string& out, uint8_t version) {
+    out.push_back('\0');
+    out.push_back('R');
+    out.push_back('L');
+    out.push_back(static_cast<char>(version));
+}
+
+// Recognises a hello at the start of a v1 stream. Returns DECODE_ERROR as
+// soon as the bytes differ from the magic, so a zero length byte followed by
+// anything else is the old shutdown frame. Only a lone zero byte is
+// ambiguous (DECODE_NEED_MORE); the caller decides how long to wait for more.
+inline DecodeResult decodeHello(const char* data, size_t available, uint8_t& version) {
+    static const char magic[HELLO_SIZE - 1] = { '\0', 'R', 'L' };
+    for (size_t i = 0; i < available && i < sizeof(magic); i++) {
+        if (data[i] != magic[i]) {
+            return DECODE_ERROR;
+        }
+    }
+    if (available < HELLO_SIZE) {
+        return DECODE_NEED_MORE;
+    }
+    if (data[3] == '\0') {
+        return DECODE_ERROR;
+    }
+    version = static_cast<uint8_t>(data[3]);
+    return DECODE_OK;
+}
+
+// Long payloads are split over consecutive frames instead of being truncated.
+inline void encodeV1(std::string& out, const char* data, size_t length) {
+    do {
+        size_t chunk = (length > V1_MAX_PAYLOAD) ? V1_MAX_PAYLOAD : length;
+        out.push_back(static_cast<char>(chunk));
+        out.append(data, chunk);
+        data += chunk;
+        length -= chunk;
+    } while (length > 0);
+}
+
+inline size_t encodedSizeV1(size_t length) {
+    size_t frames = (length + V1_MAX_PAYLOAD - 1) / V1_MAX_PAYLOAD;
+    return length + (frames > 0 ? frames : 1);
+}
+
+inline void encodeV2(std::string& out, uint8_t type, const char* data, size_t length) {
+    appendVarint(out, length + 1);
+    out.push_back(static_cast<char>(type));
+    out.append(data, length);
+}
+
+inline size_t encodedSizeV2(size_t length) {
+    return varintSize(length + 1) + 1 + length;
+}
+
+inline void encodeChatV2(std::string& out, uint64_t sequence, const char* data, size_t length) {
+    appendVarint(out, varintSize(sequence) + length + 1);
+    out.push_back(static_cast<char>(FRAME_CHAT));
+    appendVarint(out, sequence);
+    out.append(data, length);
+}
+
+inline size_t encodedSizeChatV2(uint64_t sequence, size_t length) {
+    return encodedSizeV2(varintSize(sequence) + length);
+}
+
+// Splits a FRAME_CHAT payload into its sequence number and text.
+inline bool decodeChat(const DecodedFrame& frame, uint64_t& sequence, const char*& text, size_t& length) {
+    size_t used;
+    if (frame.type != FRAME_CHAT || decodeVarint(frame.payload, frame.length, sequence, used) != DECODE_OK) {
+        return false;
+    }
+    text = frame.payload + used;
+    length = frame.length - used;
+    return true;
+}
+
+inline DecodeResult decodeV1(const char* data, size_t available, DecodedFrame& frame) {
+    frame.frameSize = 0;
+    if (available < 1) {
+        return DECODE_NEED_MORE;
+    }
+    size_t length = static_cast<uint8_t>(data[0]);
+    if (length == 0) {
+        return DECODE_ERROR;
+    }
+    frame.frameSize = 1 + length;
+    if (available < frame.frameSize) {
+        return DECODE_NEED_MORE;
+    }
+    frame.type = FRAME_TEXT;
+    frame.payload = data + 1;
+    frame.length = length;
+    return DECODE_OK;
+}
+
+// On DECODE_NEED_MORE, frame.frameSize holds the full frame size once the
+// header is complete (0 otherwise) so callers can size their buffer.
+inline DecodeResult decodeV2(const char* data, size_t available, DecodedFrame& frame) {
+    frame.frameSize = 0;
+
+    uint64_t bodyLength;
+    size_t headerSize;
+    DecodeResult result = decodeVarint(data, available, bodyLength, headerSize);
+    if (result != DECODE_OK) {
+        return result;
+    }
+    if (bodyLength == 0 || bodyLength > V2_MAX_PAYLOAD + 1) {
+        return DECODE_ERROR;
+    }
+
+    frame.frameSize = headerSize + static_cast<size_t>(bodyLength);
+    if (available < frame.frameSize) {
+        return DECODE_NEED_MORE;
+    }
+    frame.type = static_cast<uint8_t>(data[headerSize]);
+    frame.payload = data + headerSize + 1;
+    frame.length = static_cast<size_t>(bodyLength) - 1;
+    return DECODE_OK;
+}
+
+// Next frame of a stream in the given protocol (the hello aside).
+inline DecodeResult decodeFrame(int protocol, const char* data, size_t available, DecodedFrame& frame) {
+    return (protocol == PROTOCOL_V1) ? decodeV1(data, available, frame) : decodeV2(data, available, frame);
+}
+
+// Accumulates several v2 messages under a single FRAME_BATCH header.
+class BatchBuilder {
+private:
+    std::string body;
+    size_t count;
+
+public:
+    BatchBuilder() : count(0) {}
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return body.size(); }
+
+    // False if the message would push the batch past the v2 payload limit.
+    bool add(uint8_t type, const char* data, size_t length) {
+        if (body.size() + encodedSizeV2(length) > V2_MAX_PAYLOAD) {
+            return false;
+        }
+        encodeV2(body, type, data, length);
+        count++;
+        return true;
+    }
+
+    void finish(std::string& out) {
+        encodeV2(out, FRAME_BATCH, body.data(), body.size());
+        body.clear();
+        count = 0;
+    }
+};
+
+// Iterates the messages inside a FRAME_BATCH payload.
+class BatchReader {
+private:
+    const char* data;
+    size_t remaining;
+
+public:
+    BatchReader(const char* payload, size_t length) : data(payload), remaining(length) {}
+
+    // DECODE_NEED_MORE here means the batch is exhausted (or truncated).
+    DecodeResult next(DecodedFrame& frame) {
+        if (remaining == 0) {
+            return DECODE_NEED_MORE;
+        }
+        DecodeResult result = decodeV2(data, remaining, frame);
+        if (result == DECODE_OK && frame.type == FRAME_BATCH) {
+            return DECODE_ERROR;
+        }
+        if (result == DECODE_OK) {
+            data += frame.frameSize;
+            remaining -= frame.frameSize;
+        }
+        else if (result == DECODE_NEED_MORE) {
+            return DECODE_ERROR;
+        }
+        return result;
+    }
+
+    // The frames not read yet, still encoded.
+    const char* rest() const { return data; }
+    size_t remainingBytes() const { return remaining; }
+};
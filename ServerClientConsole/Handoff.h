@@ -0,0 +1,327 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Federation.h"
+#include "Platform.h"
+#include "Status.h"
+
+#ifndef _WIN32
+#include <sys/un.h>
+#endif
+
+// Hot upgrade: a running server passes its listening sockets and client
+// connections to a new process over a Unix socket, so a restart drops no one.
+// The old server listens on --upgrade-socket=PATH; the new binary, started
+// with --takeover=PATH, connects there. The old server stops reading, sends
+// every descriptor with SCM_RIGHTS followed by one state record, and exits.
+// The new process waits for that exit (end of stream) before opening the logs
+// and the user store the old one was writing to. Windows builds have no
+// descriptor passing and refuse both flags.
+//
+// Descriptors travel in messages of a u32 count with that many attached; a
+// count of 0 ends them. Then a u64 length and the state, with "str" a varint
+// length and bytes:
+//   "CHATHANDOFF2", varint listeners, varint sessions, and per session:
+//   u8 protocol, str username (empty if not logged in), str input (received,
+//   unparsed bytes, a partial frame included), str output (queued bytes not
+//   yet written), str deferred batch, varint rooms, str room name...,
+//   u8 presence notices on
+// Listeners are the first descriptors, then one per session, in order.
+
+static const char HANDOFF_MAGIC[] = "CHATHANDOFF2";
+
+struct HandoffSession {
+    SOCKET socket;
+    uint8_t protocol;
+    std::string username;
+    std::string input;
+    std::string output;
+    std::string deferredBatch;
+    std::vector<std::string> rooms;   // #room names; the lobby goes with the login
+    bool presence;                    // Asked for presence notices
+};
+
+struct HandoffState {
+    std::vector<SOCKET> listeners;
+    std::vector<HandoffSession> sessions;
+
+    void encode(std::string& out, std::vector<SOCKET>& descriptors) const {
+        out.append(HANDOFF_MAGIC, sizeof(HANDOFF_MAGIC) - 1);
+        appendVarint(out, listeners.size());
+        appendVarint(out, sessions.size());
+        descriptors = listeners;
+        for (const HandoffSession& session : sessions) {
+            descriptors.push_back(session.socket);
+            out.push_back(static_cast<char>(session.protocol));
+            appendPeerString(out, session.username);
+            appendPeerString(out, session.input);
+            appendPeerString(out, session.output);
+            appendPeerString(out, session.deferredBatch);
+            appendVarint(out, session.rooms.size());
+            for (const std::string& room : session.rooms) {
+                appendPeerString(out, room);
+            }
+            out.push_back(session.presence ? 1 : 0);
+        }
+    }
+
+    // Takes ownership of descriptors only on success.
+    bool decode(const std::string& data, const std::vector<SOCKET>& descriptors) {
+        size_t magic = sizeof(HANDOFF_MAGIC) - 1;
+        if (data.compare(0, magic, HANDOFF_MAGIC) != 0) {
+            return false;
+        }
+        PeerReader reader(data.data() + magic, data.size() - magic);
+        uint64_t listenerCount = reader.number();
+        uint64_t sessionCount = reader.number();
+        if (!reader.ok() || listenerCount + sessionCount != descriptors.size()) {
+            return false;
+        }
+        std::vector<HandoffSession> decoded(static_cast<size_t>(sessionCount));
+        for (size_t i = 0; i < decoded.size(); i++) {
+            HandoffSession& session = decoded[i];
+            session.socket = descriptors[static_cast<size_t>(listenerCount) + i];
+            session.protocol = reader.byte();
+            session.username = std::string(reader.string());
+            session.input = std::string(reader.string());
+            session.output = std::string(reader.string());
+            session.deferredBatch = std::string(reader.string());
+            uint64_t roomCount = reader.number();
+            for (uint64_t room = 0; room < roomCount && reader.ok(); room++) {
+                session.rooms.push_back(std::string(reader.string()));
+            }
+            session.presence = reader.byte() != 0;
+            if (!reader.ok() || (session.protocol != PROTOCOL_V1 && session.protocol != PROTOCOL_V2)) {
+                return false;
+            }
+        }
+        listeners.assign(descriptors.begin(), descriptors.begin() + static_cast<size_t>(listenerCount));
+        sessions = std::move(decoded);
+        return true;
+    }
+};
+
+#ifndef _WIN32
+
+static const size_t HANDOFF_FDS_PER_MESSAGE = 250;   // Under the kernel's SCM_MAX_FD
+
+inline bool handoffAddress(const std::string& path, sockaddr_un& address) {
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+inline void removeHandoffSocket(const std::string& path) {
+    unlink(path.c_str());
+}
+
+// Replaces a socket file left behind by a previous run.
+inline int listenForHandoff(const std::string& path, SOCKET& listener) {
+    sockaddr_un address;
+    if (!handoffAddress(path, address)) {
+        return SETUP_ERROR;
+    }
+    removeHandoffSocket(path);
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener == INVALID_SOCKET) {
+        return SETUP_ERROR;
+    }
+    if (bind(listener, (SOCKADDR*)&address, sizeof(address)) == SOCKET_ERROR) {
+        closesocket(listener);
+        listener = INVALID_SOCKET;
+        return BIND_ERROR;
+    }
+    if (listen(listener, 1) == SOCKET_ERROR || setNonBlocking(listener) == SOCKET_ERROR) {
+        closesocket(listener);
+        listener = INVALID_SOCKET;
+        return SETUP_ERROR;
+    }
+    return SUCCESS;
+}
+
+inline int connectForHandoff(const std::string& path, SOCKET& channel) {
+    sockaddr_un address;
+    if (!handoffAddress(path, address)) {
+        return SETUP_ERROR;
+    }
+    channel = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (channel == INVALID_SOCKET) {
+        return SETUP_ERROR;
+    }
+    if (connect(channel, (SOCKADDR*)&address, sizeof(address)) == SOCKET_ERROR) {
+        closesocket(channel);
+        channel = INVALID_SOCKET;
+        return CONNECT_ERROR;
+    }
+    return SUCCESS;
+}
+
+inline bool sendAll(SOCKET channel, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(channel, data, length, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (socketInterrupted()) continue;
+            return false;
+        }
+        data += sent;
+        length -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+inline bool receiveAll(SOCKET channel, char* data, size_t length) {
+    while (length > 0) {
+        ssize_t received = recv(channel, data, length, 0);
+        if (received < 0 && socketInterrupted()) continue;
+        if (received <= 0) {
+            return false;
+        }
+        data += received;
+        length -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+// Blocking; the channel must be in blocking mode. The caller still owns
+// (and closes) its copies of the descriptors.
+inline int sendHandoff(SOCKET channel, const HandoffState& state) {
+    std::string encoded;
+    std::vector<SOCKET> descriptors;
+    state.encode(encoded, descriptors);
+
+    size_t next = 0;
+    for (;;) {
+        uint32_t count = static_cast<uint32_t>(std::min(descriptors.size() - next, HANDOFF_FDS_PER_MESSAGE));
+        char control[CMSG_SPACE(HANDOFF_FDS_PER_MESSAGE * sizeof(int))];
+        iovec header = { &count, sizeof(count) };
+        msghdr message = {};
+        message.msg_iov = &header;
+        message.msg_iovlen = 1;
+        if (count > 0) {
+            message.msg_control = control;
+            message.msg_controllen = CMSG_SPACE(count * sizeof(int));
+            cmsghdr* rights = CMSG_FIRSTHDR(&message);
+            rights->cmsg_level = SOL_SOCKET;
+            rights->cmsg_type = SCM_RIGHTS;
+            rights->cmsg_len = CMSG_LEN(count * sizeof(int));
+            memcpy(CMSG_DATA(rights), descriptors.data() + next, count * sizeof(int));
+        }
+        ssize_t sent;
+        do {
+            sent = sendmsg(channel, &message, MSG_NOSIGNAL);
+        } while (sent < 0 && socketInterrupted());
+        if (sent != static_cast<ssize_t>(sizeof(count))) {
+            return DISCONNECT;
+        }
+        if (count == 0) {
+            break;
+        }
+        next += count;
+    }
+
+    uint64_t length = encoded.size();
+    if (!sendAll(channel, reinterpret_cast<const char*>(&length), sizeof(length)) ||
+        !sendAll(channel, encoded.data(), encoded.size())) {
+        return DISCONNECT;
+    }
+    return SUCCESS;
+}
+
+// Blocking. On failure every descriptor received so far is closed.
+inline int receiveHandoff(SOCKET channel, HandoffState& state) {
+    std::vector<SOCKET> descriptors;
+    int result = SUCCESS;
+    for (;;) {
+        uint32_t count = 0;
+        char control[CMSG_SPACE(HANDOFF_FDS_PER_MESSAGE * sizeof(int))];
+        iovec header = { &count, sizeof(count) };
+        msghdr message = {};
+        message.msg_iov = &header;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        ssize_t received;
+        do {
+            received = recvmsg(channel, &message, MSG_CMSG_CLOEXEC | MSG_WAITALL);
+        } while (received < 0 && socketInterrupted());
+        for (cmsghdr* rights = CMSG_FIRSTHDR(&message); received > 0 && rights; rights = CMSG_NXTHDR(&message, rights)) {
+            if (rights->cmsg_level == SOL_SOCKET && rights->cmsg_type == SCM_RIGHTS) {
+                size_t attached = (rights->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                const int* fds = reinterpret_cast<const int*>(CMSG_DATA(rights));
+                descriptors.insert(descriptors.end(), fds, fds + attached);
+            }
+        }
+        if (received != static_cast<ssize_t>(sizeof(count)) || (message.msg_flags & MSG_CTRUNC)) {
+            result = DISCONNECT;
+            break;
+        }
+        if (count == 0) {
+            break;
+        }
+    }
+
+    uint64_t length = 0;
+    std::string encoded;
+    if (result == SUCCESS && receiveAll(channel, reinterpret_cast<char*>(&length), sizeof(length))) {
+        encoded.resize(static_cast<size_t>(length));
+        if (!receiveAll(channel, &encoded[0], encoded.size()) || !state.decode(encoded, descriptors)) {
+            result = DISCONNECT;
+        }
+    }
+    else {
+        result = DISCONNECT;
+    }
+    if (result != SUCCESS) {
+        for (SOCKET descriptor : descriptors) {
+            closesocket(descriptor);
+        }
+    }
+    return result;
+}
+
+// Blocks until the other end closes the channel (the old process exited), or
+// timeoutMs passes. False on timeout.
+inline bool waitForHangup(SOCKET channel, int timeoutMs) {
+    pollfd entry = { channel, POLLIN, 0 };
+    char discard[256];
+    for (;;) {
+        int ready = socketPoll(&entry, 1, timeoutMs);
+        if (ready < 0 && socketInterrupted()) continue;
+        if (ready <= 0) {
+            return false;
+        }
+        ssize_t received = recv(channel, discard, sizeof(discard), 0);
+        if (received <= 0 && !(received < 0 && socketInterrupted())) {
+            return true;
+        }
+    }
+}
+
+#else
+
+inline void removeHandoffSocket(const std::string&) {}
+
+inline int listenForHandoff(const std::string&, SOCKET& listener) {
+    listener = INVALID_SOCKET;
+    return SETUP_ERROR;
+}
+
+inline int connectForHandoff(const std::string&, SOCKET& channel) {
+    channel = INVALID_SOCKET;
+    return SETUP_ERROR;
+}
+
+inline int sendHandoff(SOCKET, const HandoffState&) { return SETUP_ERROR; }
+inline int receiveHandoff(SOCKET, HandoffState&) { return SETUP_ERROR; }
+inline bool waitForHangup(SOCKET, int) { return false; }
+
+#endif
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "Frame.h"
+#include "LogRecord.h"
+
+#define HISTORY_OK 0         // Everything after the requested sequence is in memory
+#define HISTORY_EVICTED 1    // Part of the gap has already left the ring
+
+struct HistoryOptions {
+    size_t capacity;    // Messages kept in memory
+    size_t maxBytes;    // Encoded bytes kept in memory; the oldest go first past this
+
+    HistoryOptions() : capacity(4096), maxBytes(4 * 1024 * 1024) {}
+};
+
+// Recent public messages in a fixed-size ring, each stamped with a sequence
+// number that only ever increases. A reconnecting client names the last
+// sequence it saw and gets the gap replayed from the already-encoded frames.
+// For gaps that reach past the ring, sparse checkpoints (sequence, timestamp)
+// say where on disk to look.
+class HistoryRing {
+public:
+    struct Checkpoint {
+        uint64_t sequence;
+        uint64_t timestamp;
+    };
+
+private:
+    struct Entry {
+        uint64_t sequence;
+        FramePtr frame;
+    };
+
+    static const uint64_t CHECKPOINT_INTERVAL = 256;   // Sequences between disk checkpoints
+    static const size_t MAX_CHECKPOINTS = 64 * 1024;
+
+    std::mutex mutex;
+    std::vector<Entry> entries;     // Ring storage, capacity slots
+    size_t head;                    // Oldest entry
+    size_t count;
+    size_t bytes;
+    size_t maxBytes;
+    uint64_t nextSequence;
+    std::vector<Checkpoint> checkpoints;
+
+    size_t frameBytes(const FramePtr& frame) const {
+        return frame->size(PROTOCOL_V1) + frame->size(PROTOCOL_V2);
+    }
+
+    void evictOldest() {
+        Entry& oldest = entries[head];
+        bytes -= frameBytes(oldest.frame);
+        oldest.frame.reset();
+        head = (head + 1) % entries.size();
+        count--;
+    }
+
+public:
+    std::atomic<uint64_t> resumes;
+    std::atomic<uint64_t> replayedFromMemory;
+    std::atomic<uint64_t> replayedFromLog;
+
+    HistoryRing() : head(0), count(0), bytes(0), maxBytes(0), nextSequence(1),
+        resumes(0), replayedFromMemory(0), replayedFromLog(0) {}
+
+    // lastSequence/lastTimestamp describe the newest message already on disk (0 if none).
+    void configure(const HistoryOptions& options, uint64_t lastSequence, uint64_t lastTimestamp) {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.assign(options.capacity > 0 ? options.capacity : 1, Entry());
+        head = 0;
+        count = 0;
+        bytes = 0;
+        maxBytes = options.maxBytes;
+        nextSequence = lastSequence + 1;
+        checkpoints.clear();
+        if (lastSequence > 0) {
+            checkpoints.push_back(Checkpoint{ lastSequence, lastTimestamp });
+        }
+    }
+
+    // Stamps the next message. encode(sequence, timestamp) builds its frame and
+    // must log it; both run under the ring lock so sequence, timestamp and log
+    // order always agree.
+    template <typename Encode>
+    FramePtr publish(Encode encode) {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t sequence = nextSequence++;
+        uint64_t timestamp = logTimestampNow();
+        FramePtr frame = encode(sequence, timestamp);
+
+        if (sequence % CHECKPOINT_INTERVAL == 0 || checkpoints.empty()) {
+            if (checkpoints.size() == MAX_CHECKPOINTS) {
+                checkpoints.erase(checkpoints.begin(), checkpoints.begin() + MAX_CHECKPOINTS / 2);
+            }
+            checkpoints.push_back(Checkpoint{ sequence, timestamp });
+        }
+
+        size_t size = frameBytes(frame);
+        while (count > 0 && (count == entries.size() || bytes + size > maxBytes)) {
+            evictOldest();
+        }
+        Entry& slot = entries[(head + count) % entries.size()];
+        slot.sequence = sequence;
+        slot.frame = frame;
+        count++;
+        bytes += size;
+        return frame;
+    }
+
+    uint64_t lastSequence() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return nextSequence - 1;
+    }
+
+    // Frames for every message after the given sequence that is still held.
+    // oldest is the first sequence in memory (or the next to be issued).
+    int collect(uint64_t after, std::vector<FramePtr>& frames, uint64_t& oldest) {
+        std::lock_guard<std::mutex> lock(mutex);
+        oldest = (count > 0) ? entries[head].sequence : nextSequence;
+        uint64_t first = after + 1;
+        size_t skip = (first > oldest) ? static_cast<size_t>(first - oldest) : 0;
+        for (size_t i = skip; i < count; i++) {
+            frames.push_back(entries[(head + i) % entries.size()].frame);
+        }
+        return (first < oldest) ? HISTORY_EVICTED : HISTORY_OK;
+    }
+
+    // Latest checkpoint at or before the given sequence.
+    bool checkpointAtOrBefore(uint64_t sequence, Checkpoint& checkpoint) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), sequence,
+            [](uint64_t value, const Checkpoint& entry) { return value < entry.sequence; });
+        if (it == checkpoints.begin()) {
+            return false;
+        }
+        checkpoint = *(it - 1);
+        return true;
+    }
+};
@@ -0,0 +1,295 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <string_view>
+
+// Binary log record, little-endian:
+//   u32 length (bytes after this field)
+//   u64 timestamp (microseconds since the Unix epoch)
+//   u8  type
+//   u8  user length, user bytes
+//   payload (rest of the record)
+// Every log segment file starts with LOG_FILE_MAGIC.
+
+enum LogRecordType : uint8_t {
+    LOG_COMMAND = 1,    // payload: command text without the command character
+    LOG_LOGOUT = 2,     // payload: empty
+    LOG_PUBLIC = 3,     // payload: message text
+    LOG_PRIVATE = 4,    // payload: "<recipient> <message text>"
+    LOG_CHAT = 5,       // payload: u64 history sequence, message text (public messages since history)
+    LOG_ROOM = 6,       // payload: "<#room> <message text>"
+    LOG_CAPTURE_OPEN = 7,   // Traffic capture (--capture): capture payload, no bytes
+    LOG_CAPTURE_DATA = 8,   // capture payload, then the bytes one read returned
+    LOG_CAPTURE_CLOSE = 9   // capture payload, no bytes
+};
+
+static const char LOG_FILE_MAGIC[8] = { 'C', 'H', 'A', 'T', 'L', 'O', 'G', '1' };
+static const size_t LOG_RECORD_HEADER = 4 + 8 + 1 + 1;
+
+struct LogEntry {
+    uint64_t timestampMicros;
+    uint8_t type;
+    std::string_view user;
+    std::string_view payload;
+};
+
+inline uint64_t logTimestampNow() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+inline void encodeLogRecord(std::string& out, uint64_t timestamp, uint8_t type, std::string_view user, std::string_view payload) {
+    if (user.size() > 255) user = user.substr(0, 255);
+    uint32_t length = static_cast<uint32_t>(LOG_RECORD_HEADER - 4 + user.size() + payload.size());
+    out.reserve(out.size() + 4 + length);
+    for (int i = 0; i < 4; i++) out.push_back(static_cast<char>(length >> (8 * i)));
+    for (int i = 0; i < 8; i++) out.push_back(static_cast<char>(timestamp >> (8 * i)));
+    out.push_back(static_cast<char>(type));
+    out.push_back(static_cast<char>(user.size()));
+    out.append(user.data(), user.size());
+    out.append(payload.data(), payload.size());
+}
+
+// Parses one record from the front of data. Returns the bytes it spans, or 0
+// if data holds no complete, well-formed record.
+inline size_t decodeLogRecord(const char* data, size_t available, LogEntry& entry) {
+    if (available < LOG_RECORD_HEADER) return 0;
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    uint32_t length = 0;
+    for (int i = 0; i < 4; i++) length |= static_cast<uint32_t>(bytes[i]) << (8 * i);
+    if (length < LOG_RECORD_HEADER - 4 || available - 4 < length) return 0;
+    uint64_t timestamp = 0;
+    for (int i = 0; i < 8; i++) timestamp |= static_cast<uint64_t>(bytes[4 + i]) << (8 * i);
+    size_t userLength = bytes[13];
+    if (LOG_RECORD_HEADER - 4 + userLength > length) return 0;
+
+    entry.timestampMicros = timestamp;
+    entry.type = bytes[12];
+    entry.user = std::string_view(data + LOG_RECORD_HEADER, userLength);
+    entry.payload = std::string_view(data + LOG_RECORD_HEADER + userLength, length - (LOG_RECORD_HEADER - 4) - userLength);
+    return 4 + static_cast<size_t>(length);
+}
+
+inline void encodeChatPayload(std::string& out, uint64_t sequence, std::string_view message) {
+    for (int i = 0; i < 8; i++) out.push_back(static_cast<char>(sequence >> (8 * i)));
+    out.append(message.data(), message.size());
+}
+
+// Sequence number and text of a LOG_CHAT record.
+inline bool decodeChatPayload(const LogEntry& entry, uint64_t& sequence, std::string_view& message) {
+    if (entry.type != LOG_CHAT || entry.payload.size() < 8) {
+        return false;
+    }
+    sequence = 0;
+    for (int i = 0; i < 8; i++) sequence |= static_cast<uint64_t>(static_cast<uint8_t>(entry.payload[i])) << (8 * i);
+    message = entry.payload.substr(8);
+    return true;
+}
+
+// Capture records start with u32 connection id and u64 nanoseconds since the
+// capture started (a monotonic clock, unlike the record timestamp).
+inline void encodeCapturePayload(std::string& out, uint32_t connection, uint64_t nanos, std::string_view data) {
+    out.reserve(out.size() + 12 + data.size());
+    for (int i = 0; i < 4; i++) out.push_back(static_cast<char>(connection >> (8 * i)));
+    for (int i = 0; i < 8; i++) out.push_back(static_cast<char>(nanos >> (8 * i)));
+    out.append(data.data(), data.size());
+}
+
+inline bool decodeCapturePayload(const LogEntry& entry, uint32_t& connection, uint64_t& nanos, std::string_view& data) {
+    if (entry.type < LOG_CAPTURE_OPEN || entry.type > LOG_CAPTURE_CLOSE || entry.payload.size() < 12) {
+        return false;
+    }
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(entry.payload.data());
+    connection = 0;
+    for (int i = 0; i < 4; i++) connection |= static_cast<uint32_t>(bytes[i]) << (8 * i);
+    nanos = 0;
+    for (int i = 0; i < 8; i++) nanos |= static_cast<uint64_t>(bytes[4 + i]) << (8 * i);
+    data = entry.payload.substr(12);
+    return true;
+}
+
+// Human-readable view, matching the old text logs line for line.
+inline std::string formatLogEntry(const LogEntry& entry) {
+    std::string text;
+    switch (entry.type) {
+    case LOG_COMMAND:
+        text.append("User: ").append(entry.user).append(", Command: ").append(entry.payload);
+        break;
+    case LOG_LOGOUT:
+        text.append("User: ").append(entry.user).append(" has logged out.");
+        break;
+    case LOG_PUBLIC:
+        text.append(entry.user).append(": ").append(entry.payload);
+        break;
+    case LOG_CHAT:
+        text.append(entry.user).append(": ").append(entry.payload.substr(entry.payload.size() < 8 ? entry.payload.size() : 8));
+        break;
+    case LOG_PRIVATE: {
+        size_t split = entry.payload.find(' ');
+        std::string_view recipient = entry.payload.substr(0, split);
+        std::string_view message = (split == std::string_view::npos) ? std::string_view() : entry.payload.substr(split + 1);
+        text.append("[Private] ").append(entry.user).append(" to ").append(recipient).append(": ").append(message);
+        break;
+    }
+    case LOG_ROOM: {
+        size_t split = entry.payload.find(' ');
+        std::string_view room = entry.payload.substr(0, split);
+        std::string_view message = (split == std::string_view::npos) ? std::string_view() : entry.payload.substr(split + 1);
+        text.append("[").append(room).append("] ").append(entry.user).append(": ").append(message);
+        break;
+    }
+    case LOG_CAPTURE_OPEN:
+    case LOG_CAPTURE_DATA:
+    case LOG_CAPTURE_CLOSE: {
+        uint32_t connection;
+        uint64_t nanos;
+        std::string_view data;
+        if (decodeCapturePayload(entry, connection, nanos, data)) {
+            static const char* events[] = { "open", "data", "close" };
+            text.append("[capture] conn ").append(std::to_string(connection)).append(" +").append(std::to_string(nanos))
+                .append(" ns ").append(events[entry.type - LOG_CAPTURE_OPEN]);
+            if (entry.type == LOG_CAPTURE_DATA) {
+                text.append(" ").append(std::to_string(data.size())).append(" bytes");
+            }
+            break;
+        }
+        text.append("[capture] malformed");
+        break;
+    }
+    default:
+        text.append("[type ").append(std::to_string(entry.type)).append("] ").append(entry.user).append(": ").append(entry.payload);
+        break;
+    }
+    return text;
+}
+
+inline std::string formatLogTimestamp(uint64_t timestampMicros) {
+    time_t seconds = static_cast<time_t>(timestampMicros / 1000000);
+    tm utc;
+#ifdef _WIN32
+    gmtime_s(&utc, &seconds);
+#else
+    gmtime_r(&seconds, &utc);
+#endif
+    char text[40];
+    size_t length = strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &utc);
+    snprintf(text + length, sizeof(text) - length, ".%06u", static_cast<unsigned>(timestampMicros % 1000000));
+    return text;
+}
+
+// Accepts Unix seconds ("1760000000", "1760000000.25") or UTC calendar time
+// ("2026-10-17", "2026-10-17T09:30:00", "2026-10-17T09:30:00.123456").
+inline bool parseLogTime(std::string_view text, uint64_t& timestampMicros) {
+    std::string value(text);
+    unsigned long long seconds = 0;
+    int consumed = 0;
+    int year, month, day, hour = 0, minute = 0, second = 0;
+    const char* fraction = nullptr;
+
+    if (sscanf(value.c_str(), "%d-%d-%d%n", &year, &month, &day, &consumed) == 3) {
+        const char* rest = value.c_str() + consumed;
+        if (*rest == 'T') {
+            int timeConsumed = 0;
+            if (sscanf(rest + 1, "%d:%d:%d%n", &hour, &minute, &second, &timeConsumed) != 3) {
+                return false;
+            }
+            rest += 1 + timeConsumed;
+        }
+        if (*rest != '\0' && *rest != '.') {
+            return false;
+        }
+        fraction = rest;
+        tm utc = {};
+        utc.tm_year = year - 1900;
+        utc.tm_mon = month - 1;
+        utc.tm_mday = day;
+        utc.tm_hour = hour;
+        utc.tm_min = minute;
+        utc.tm_sec = second;
+#ifdef _WIN32
+        time_t converted = _mkgmtime(&utc);
+#else
+        time_t converted = timegm(&utc);
+#endif
+        if (converted < 0) {
+            return false;
+        }
+        seconds = static_cast<unsigned long long>(converted);
+    }
+    else if (sscanf(value.c_str(), "%llu%n", &seconds, &consumed) == 1) {
+        fraction = value.c_str() + consumed;
+        if (*fraction != '\0' && *fraction != '.') {
+            return false;
+        }
+    }
+    else {
+        return false;
+    }
+
+    uint64_t micros = 0;
+    if (*fraction == '.') {
+        uint64_t scale = 100000;
+        for (const char* c = fraction + 1; *c != '\0'; c++) {
+            if (*c < '0' || *c > '9') {
+                return false;
+            }
+            micros += (*c - '0') * scale;
+            scale /= 10;
+        }
+    }
+    timestampMicros = seconds * 1000000 + micros;
+    return true;
+}
+
+// Sequential reader over a log file written by AsyncLog.
+class LogReader {
+private:
+    FILE* file;
+    std::string buffer;
+    size_t offset;
+
+    bool refill() {
+        buffer.erase(0, offset);
+        offset = 0;
+        char chunk[64 * 1024];
+        size_t count = fread(chunk, 1, sizeof(chunk), file);
+        buffer.append(chunk, count);
+        return count > 0;
+    }
+
+public:
+    LogReader() : file(nullptr), offset(0) {}
+    ~LogReader() { if (file) fclose(file); }
+
+    LogReader(const LogReader&) = delete;
+    LogReader& operator=(const LogReader&) = delete;
+
+    bool open(const std::string& path) {
+        file = fopen(path.c_str(), "rb");
+        char magic[sizeof(LOG_FILE_MAGIC)];
+        if (!file || fread(magic, 1, sizeof(magic), file) != sizeof(magic) ||
+            std::string_view(magic, sizeof(magic)) != std::string_view(LOG_FILE_MAGIC, sizeof(LOG_FILE_MAGIC))) {
+            return false;
+        }
+        return true;
+    }
+
+    // The entry's views stay valid until the next call. A torn record at the
+    // end of the file (crash mid-write) ends the stream.
+    bool next(LogEntry& entry) {
+        for (;;) {
+            size_t size = decodeLogRecord(buffer.data() + offset, buffer.size() - offset, entry);
+            if (size > 0) {
+                offset += size;
+                return true;
+            }
+            if (!refill()) {
+                return false;
+            }
+        }
+    }
+};
@@ -0,0 +1,307 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "LogRecord.h"
+#include "MappedFile.h"
+
+// A log is a run of numbered segment files, <prefix>.000001.rlog and up, each
+// with a sparse index sidecar (.ridx). Records are numbered from 0 across the
+// whole log, so "the last N" or "page P" map straight to a record range.
+
+static const char LOG_SEGMENT_EXTENSION[] = ".rlog";
+static const char LOG_INDEX_EXTENSION[] = ".ridx";
+
+inline std::string logSegmentPath(const std::string& prefix, uint32_t sequence, const char* extension) {
+    char number[16];
+    snprintf(number, sizeof(number), ".%06u", sequence);
+    return prefix + number + extension;
+}
+
+inline bool logFileExists(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file) {
+        fclose(file);
+    }
+    return file != nullptr;
+}
+
+// Sparse index entry: where one record starts. The sidecar stores each entry
+// as three little-endian u64s, with the record number relative to the segment.
+struct LogIndexEntry {
+    uint64_t record;      // Record number across the whole log
+    uint64_t timestamp;
+    uint64_t offset;      // Byte offset of the record within its segment
+};
+
+static const size_t LOG_INDEX_ENTRY_SIZE = 24;
+
+inline void encodeIndexEntry(std::string& out, const LogIndexEntry& entry, uint64_t firstRecord) {
+    uint64_t fields[3] = { entry.record - firstRecord, entry.timestamp, entry.offset };
+    for (uint64_t field : fields) {
+        for (int i = 0; i < 8; i++) out.push_back(static_cast<char>(field >> (8 * i)));
+    }
+}
+
+inline LogIndexEntry decodeIndexEntry(const char* data, uint64_t firstRecord) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    uint64_t fields[3] = { 0, 0, 0 };
+    for (int f = 0; f < 3; f++) {
+        for (int i = 0; i < 8; i++) fields[f] |= static_cast<uint64_t>(bytes[f * 8 + i]) << (8 * i);
+    }
+    return LogIndexEntry{ fields[0] + firstRecord, fields[1], fields[2] };
+}
+
+struct LogSegment {
+    uint32_t sequence;
+    std::string path;
+    uint64_t firstRecord;
+    uint64_t recordCount;
+    uint64_t bytes;                        // Committed bytes, magic included
+    std::vector<LogIndexEntry> index;      // The segment's first record is always indexed
+    std::shared_ptr<MappedFile> mapping;   // Read view, remapped once bytes outgrow it
+
+    LogSegment() : sequence(0), firstRecord(0), recordCount(0), bytes(0) {}
+};
+
+// Rebuilds a segment's catalog entry from disk. The sidecar is trusted as far
+// as it agrees with the segment; records after the last indexed one are
+// scanned, so a crash that left the index short or tore the final record
+// costs at most one index interval of reading. Returns false if the segment
+// file does not exist.
+inline bool loadLogSegment(const std::string& prefix, uint32_t sequence, uint64_t firstRecord,
+                           size_t indexInterval, LogSegment& segment) {
+    segment.sequence = sequence;
+    segment.path = logSegmentPath(prefix, sequence, LOG_SEGMENT_EXTENSION);
+    segment.firstRecord = firstRecord;
+
+    FILE* file = fopen(segment.path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fclose(file);
+
+    MappedFile mapping;
+    if (fileSize < static_cast<long>(sizeof(LOG_FILE_MAGIC)) || !mapping.map(segment.path, static_cast<size_t>(fileSize)) ||
+        std::string_view(mapping.data(), sizeof(LOG_FILE_MAGIC)) != std::string_view(LOG_FILE_MAGIC, sizeof(LOG_FILE_MAGIC))) {
+        return true;   // Not a log segment; keep the number taken but serve nothing from it
+    }
+    size_t size = mapping.size();
+
+    std::string indexPath = logSegmentPath(prefix, sequence, LOG_INDEX_EXTENSION);
+    std::string stored;
+    if (FILE* indexFile = fopen(indexPath.c_str(), "rb")) {
+        char chunk[64 * 1024];
+        size_t count;
+        while ((count = fread(chunk, 1, sizeof(chunk), indexFile)) > 0) {
+            stored.append(chunk, count);
+        }
+        fclose(indexFile);
+    }
+
+    std::vector<LogIndexEntry>& index = segment.index;
+    for (size_t at = 0; at + LOG_INDEX_ENTRY_SIZE <= stored.size(); at += LOG_INDEX_ENTRY_SIZE) {
+        LogIndexEntry entry = decodeIndexEntry(stored.data() + at, firstRecord);
+        bool ordered = index.empty()
+            ? (entry.record == firstRecord && entry.offset == sizeof(LOG_FILE_MAGIC))
+            : (entry.record > index.back().record && entry.offset > index.back().offset);
+        if (!ordered || entry.offset >= size) {
+            break;
+        }
+        index.push_back(entry);
+    }
+    size_t trusted = index.size();
+
+    LogEntry record;
+    if (!index.empty() && decodeLogRecord(mapping.data() + index.back().offset, size - index.back().offset, record) == 0) {
+        index.clear();
+        trusted = 0;
+    }
+
+    uint64_t offset = index.empty() ? sizeof(LOG_FILE_MAGIC) : index.back().offset;
+    uint64_t number = index.empty() ? firstRecord : index.back().record;
+    for (;;) {
+        size_t recordSize = decodeLogRecord(mapping.data() + offset, size - offset, record);
+        if (recordSize == 0) {
+            break;
+        }
+        if (index.empty() || offset >= index.back().offset + indexInterval) {
+            index.push_back(LogIndexEntry{ number, record.timestampMicros, offset });
+        }
+        offset += recordSize;
+        number++;
+    }
+    segment.recordCount = number - firstRecord;
+    segment.bytes = offset;
+
+    if (trusted != index.size() || trusted * LOG_INDEX_ENTRY_SIZE != stored.size()) {
+        std::string encoded;
+        for (const LogIndexEntry& entry : index) {
+            encodeIndexEntry(encoded, entry, firstRecord);
+        }
+        if (FILE* indexFile = fopen(indexPath.c_str(), "wb")) {
+            fwrite(encoded.data(), 1, encoded.size(), indexFile);
+            fclose(indexFile);
+        }
+    }
+    return true;
+}
+
+// In-memory catalog of a log's segments. The log writer publishes every commit;
+// readers on any thread find a record through the sparse index and decode it
+// straight out of the mapped segment, so a lookup touches one index interval
+// plus the records it returns, however large the log is.
+class LogCatalog {
+private:
+    struct Cursor {
+        std::shared_ptr<MappedFile> mapping;   // Keeps the view alive outside the lock
+        uint64_t offset;
+        uint64_t record;
+        uint64_t endOffset;
+        uint64_t endRecord;
+    };
+
+    std::mutex mutex;
+    std::vector<LogSegment> segments;   // Only segments with records, plus the active one
+    uint64_t totalRecords;
+
+    // Caller holds the mutex.
+    LogSegment* segmentFor(uint64_t record) {
+        auto it = std::upper_bound(segments.begin(), segments.end(), record,
+            [](uint64_t value, const LogSegment& segment) { return value < segment.firstRecord; });
+        if (it == segments.begin()) {
+            return nullptr;
+        }
+        --it;
+        return (record < it->firstRecord + it->recordCount) ? &*it : nullptr;
+    }
+
+    // Caller holds the mutex.
+    bool cursorAt(LogSegment& segment, const LogIndexEntry& start, Cursor& cursor) {
+        if (!segment.mapping || segment.mapping->size() < segment.bytes) {
+            std::shared_ptr<MappedFile> mapping = std::make_shared<MappedFile>();
+            if (!mapping->map(segment.path, static_cast<size_t>(segment.bytes))) {
+                return false;
+            }
+            segment.mapping = mapping;
+        }
+        cursor.mapping = segment.mapping;
+        cursor.offset = start.offset;
+        cursor.record = start.record;
+        cursor.endOffset = segment.bytes;
+        cursor.endRecord = segment.firstRecord + segment.recordCount;
+        return true;
+    }
+
+public:
+    LogCatalog() : totalRecords(0) {}
+
+    uint64_t recordCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return totalRecords;
+    }
+
+    // Writer side: appends a segment; commits after this go to it.
+    void addSegment(LogSegment segment) {
+        std::lock_guard<std::mutex> lock(mutex);
+        totalRecords = segment.firstRecord + segment.recordCount;
+        segments.push_back(std::move(segment));
+    }
+
+    // Writer side: records flushed to the newest segment.
+    void commit(uint64_t records, uint64_t bytes, const std::vector<LogIndexEntry>& entries) {
+        std::lock_guard<std::mutex> lock(mutex);
+        LogSegment& active = segments.back();
+        active.recordCount += records;
+        active.bytes += bytes;
+        active.index.insert(active.index.end(), entries.begin(), entries.end());
+        totalRecords += records;
+    }
+
+    // Calls visit(const LogEntry&) for up to limit records starting at record
+    // number first, stopping early once visit returns false. Entry views are
+    // only valid during the call.
+    template <typename Visit>
+    size_t read(uint64_t first, size_t limit, Visit visit) {
+        size_t visited = 0;
+        while (visited < limit) {
+            Cursor cursor;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                LogSegment* segment = segmentFor(first);
+                if (!segment) {
+                    break;
+                }
+                auto start = std::upper_bound(segment->index.begin(), segment->index.end(), first,
+                    [](uint64_t value, const LogIndexEntry& entry) { return value < entry.record; }) - 1;
+                if (!cursorAt(*segment, *start, cursor)) {
+                    break;
+                }
+            }
+
+            LogEntry entry;
+            while (cursor.record < cursor.endRecord && visited < limit) {
+                size_t size = decodeLogRecord(cursor.mapping->data() + cursor.offset,
+                    static_cast<size_t>(cursor.endOffset - cursor.offset), entry);
+                if (size == 0) {
+                    return visited;
+                }
+                if (cursor.record >= first) {
+                    visited++;
+                    if (!visit(entry)) {
+                        return visited;
+                    }
+                }
+                cursor.offset += size;
+                cursor.record++;
+            }
+            first = cursor.record;
+        }
+        return visited;
+    }
+
+    // First record stamped at or after timestamp, or recordCount() if none is.
+    // Stamps are taken at append time on several threads, so neighbouring
+    // records can be out of order by a few microseconds.
+    uint64_t findTime(uint64_t timestamp) {
+        Cursor cursor;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            LogSegment* segment = nullptr;
+            for (size_t i = segments.size(); i-- > 0;) {
+                if (segments[i].recordCount > 0 && segments[i].index.front().timestamp < timestamp) {
+                    segment = &segments[i];
+                    break;
+                }
+            }
+            if (!segment) {
+                return segments.empty() ? 0 : segments.front().firstRecord;
+            }
+            auto start = std::partition_point(segment->index.begin(), segment->index.end(),
+                [timestamp](const LogIndexEntry& entry) { return entry.timestamp < timestamp; }) - 1;
+            if (!cursorAt(*segment, *start, cursor)) {
+                return totalRecords;
+            }
+        }
+
+        LogEntry entry;
+        while (cursor.record < cursor.endRecord) {
+            size_t size = decodeLogRecord(cursor.mapping->data() + cursor.offset,
+                static_cast<size_t>(cursor.endOffset - cursor.offset), entry);
+            if (size == 0 || entry.timestampMicros >= timestamp) {
+                break;
+            }
+            cursor.offset += size;
+            cursor.record++;
+        }
+        return cursor.record;
+    }
+};
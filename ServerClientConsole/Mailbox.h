@@ -0,0 +1,75 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "Platform.h"
+#include "Status.h"
+
+// Cross-thread task queue owned by one reactor. Other threads post closures;
+// the owner registers wakeSocket() with its poller and drains on readiness.
+class Mailbox {
+private:
+    std::mutex mutex;
+    std::vector<std::function<void()>> tasks;
+    SOCKET wakeSockets[2];  // [0] is polled by the owner, [1] is written by posters
+    bool signalled;         // A wake byte is in flight; later posts skip the syscall
+
+public:
+    Mailbox() : signalled(false) {
+        if (createSocketPair(wakeSockets) != 0) {
+            wakeSockets[0] = wakeSockets[1] = INVALID_SOCKET;
+            return;
+        }
+        setNonBlocking(wakeSockets[0]);
+        setNonBlocking(wakeSockets[1]);
+    }
+
+    ~Mailbox() {
+        if (wakeSockets[0] != INVALID_SOCKET) closesocket(wakeSockets[0]);
+        if (wakeSockets[1] != INVALID_SOCKET) closesocket(wakeSockets[1]);
+    }
+
+    Mailbox(const Mailbox&) = delete;
+    Mailbox& operator=(const Mailbox&) = delete;
+
+    bool valid() const { return wakeSockets[0] != INVALID_SOCKET; }
+    SOCKET wakeSocket() const { return wakeSockets[0]; }
+
+    void post(std::function<void()> task) {
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+            wake = !signalled;
+            signalled = true;
+        }
+        if (wake) {
+            char byte = 1;
+            send(wakeSockets[1], &byte, 1, MSG_NOSIGNAL);
+        }
+    }
+
+    // Wakes the owner without queuing anything; lock-free so it is signal-safe.
+    void wake() {
+        char byte = 1;
+        send(wakeSockets[1], &byte, 1, MSG_NOSIGNAL);
+    }
+
+    // Runs every queued task on the calling (owning) thread.
+    void drain() {
+        char scratch[64];
+        while (recv(wakeSockets[0], scratch, sizeof(scratch), 0) > 0) {}
+
+        std::vector<std::function<void()>> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            batch.swap(tasks);
+            signalled = false;
+        }
+        for (auto& task : batch) {
+            task();
+        }
+    }
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Read-only memory map of the first bytes of a file. Bytes appended after the
+// mapping was made are not part of it; map again to see them.
+class MappedFile {
+private:
+    const char* bytes;
+    size_t length;
+
+    void unmap() {
+        if (bytes) {
+#ifdef _WIN32
+            UnmapViewOfFile(bytes);
+#else
+            munmap(const_cast<char*>(bytes), length);
+#endif
+        }
+        bytes = nullptr;
+        length = 0;
+    }
+
+public:
+    MappedFile() : bytes(nullptr), length(0) {}
+    ~MappedFile() { unmap(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // The file must already hold at least size bytes.
+    bool map(const std::string& path, size_t size) {
+        unmap();
+        if (size == 0) {
+            return false;
+        }
+#ifdef _WIN32
+        // Share write access: the log writer keeps appending to the active segment
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        ULARGE_INTEGER mapSize;
+        mapSize.QuadPart = size;
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, mapSize.HighPart, mapSize.LowPart, nullptr);
+        CloseHandle(file);
+        if (!mapping) {
+            return false;
+        }
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+        CloseHandle(mapping);
+        if (!view) {
+            return false;
+        }
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        void* view = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (view == MAP_FAILED) {
+            return false;
+        }
+#endif
+        bytes = static_cast<const char*>(view);
+        length = size;
+        return true;
+    }
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+};
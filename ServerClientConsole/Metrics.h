@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Log-linear histogram in the style of HdrHistogram: each power of two is
+// split into 16 sub-buckets, so any recorded value is reported within 1/16
+// (6.25%) of itself. Recording is a handful of relaxed atomic adds; nothing
+// allocates after construction, so it can sit on the event-loop hot path.
+class Histogram {
+private:
+    static const int SUB_BUCKET_BITS = 4;
+    static const uint64_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+    static const size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    std::atomic<uint64_t> buckets[BUCKET_COUNT];
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> sumValues;
+    std::atomic<uint64_t> maxValue;
+
+    static int highestBit(uint64_t value) {
+#if defined(_MSC_VER) && defined(_M_IX86)
+        // No 64-bit scan on 32-bit x86: try the high half, then the low
+        unsigned long index;
+        if (_BitScanReverse(&index, static_cast<unsigned long>(value >> 32))) {
+            return static_cast<int>(index) + 32;
+        }
+        _BitScanReverse(&index, static_cast<unsigned long>(value));
+        return static_cast<int>(index);
+#elif defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return static_cast<int>(index);
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    static size_t bucketFor(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+        int shift = highestBit(value) - SUB_BUCKET_BITS;
+        return static_cast<size_t>((shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1)));
+    }
+
+    // Largest value that lands in the bucket.
+    static uint64_t bucketLimit(size_t bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+        int shift = static_cast<int>(bucket / SUB_BUCKETS) - 1;
+        uint64_t sub = bucket % SUB_BUCKETS;
+        return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+    }
+
+public:
+    Histogram() : total(0), sumValues(0), maxValue(0) {
+        for (std::atomic<uint64_t>& bucket : buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void record(uint64_t value) {
+        buckets[bucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sumValues.fetch_add(value, std::memory_order_relaxed);
+        uint64_t seen = maxValue.load(std::memory_order_relaxed);
+        while (value > seen && !maxValue.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+    }
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return sumValues.load(std::memory_order_relaxed); }
+    uint64_t maxRecorded() const { return maxValue.load(std::memory_order_relaxed); }
+
+    // Value at or below which the given fraction of recordings fall (0 if empty).
+    // Concurrent recordings may or may not be counted.
+    uint64_t percentile(double fraction) const {
+        uint64_t recorded = count();
+        if (recorded == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(recorded) + 0.5);
+        rank = (rank < 1) ? 1 : rank;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; i++) {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                uint64_t limit = bucketLimit(i);
+                uint64_t highest = maxRecorded();
+                return (limit < highest) ? limit : highest;
+            }
+        }
+        return maxRecorded();
+    }
+};
+
+inline uint64_t elapsedNanos(std::chrono::steady_clock::time_point since) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - since).count());
+}
+
+// "p50 1.2 us, p99 8.0 us, p99.9 30.1 us, max 41.7 us (1234 samples)" for a
+// histogram of nanoseconds; plain numbers otherwise.
+inline void formatHistogram(std::ostream& out, const Histogram& histogram, bool nanoseconds) {
+    auto value = [&](uint64_t v) {
+        if (!nanoseconds) {
+            out << v;
+            return;
+        }
+        uint64_t tenths = (v + 50) / 100;
+        out << tenths / 10 << "." << tenths % 10 << " us";
+    };
+    out << "p50 ";
+    value(histogram.percentile(0.50));
+    out << ", p99 ";
+    value(histogram.percentile(0.99));
+    out << ", p99.9 ";
+    value(histogram.percentile(0.999));
+    out << ", max ";
+    value(histogram.maxRecorded());
+    out << " (" << histogram.count() << " samples)";
+}
+
+// Prometheus text exposition of a histogram as a summary.
+inline void exportHistogram(std::ostream& out, const std::string& name, const std::string& labels, const Histogram& histogram) {
+    static const char* quantiles[] = { "0.5", "0.9", "0.99", "0.999" };
+    static const double fractions[] = { 0.5, 0.9, 0.99, 0.999 };
+    std::string prefix = labels.empty() ? "{" : "{" + labels + ",";
+    for (int i = 0; i < 4; i++) {
+        out << name << prefix << "quantile=\"" << quantiles[i] << "\"} " << histogram.percentile(fractions[i]) << "\n";
+    }
+    std::string suffix = labels.empty() ? "" : "{" + labels + "}";
+    out << name << "_sum" << suffix << " " << histogram.sum() << "\n";
+    out << name << "_count" << suffix << " " << histogram.count() << "\n";
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include "Platform.h"
+#include "Status.h"
+
+// Plain-text scrape endpoint on a loopback port. Every connection gets one
+// HTTP/1.0 response carrying render()'s output and is closed, so both curl
+// and a Prometheus scraper can read it. Runs on its own thread: a slow
+// scraper never holds up an event loop.
+class MetricsEndpoint {
+private:
+    SOCKET listenSocket;
+    std::thread thread;
+    std::atomic<bool> running;
+    std::function<std::string()> render;
+
+    static const int POLL_INTERVAL_MS = 200;    // How quickly stop() is noticed
+    static const int REQUEST_TIMEOUT_MS = 1000;
+
+    void serve() {
+        while (running) {
+            pollfd listener = {};
+            listener.fd = listenSocket;
+            listener.events = POLLIN;
+            if (socketPoll(&listener, 1, POLL_INTERVAL_MS) <= 0) {
+                continue;
+            }
+            SOCKET client = accept(listenSocket, nullptr, nullptr);
+            if (client == INVALID_SOCKET) {
+                continue;
+            }
+            respond(client);
+            closesocket(client);
+        }
+    }
+
+    void respond(SOCKET client) {
+        // Read (and ignore) the request so closing does not reset the connection
+        pollfd request = {};
+        request.fd = client;
+        request.events = POLLIN;
+        char buffer[1024];
+        if (socketPoll(&request, 1, REQUEST_TIMEOUT_MS) > 0) {
+            recv(client, buffer, sizeof(buffer), 0);
+        }
+
+        std::string body = render();
+        std::string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+            std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+        size_t sent = 0;
+        while (sent < response.size()) {
+            int result = send(client, response.data() + sent, static_cast<int>(response.size() - sent), MSG_NOSIGNAL);
+            if (result <= 0) {
+                break;
+            }
+            sent += static_cast<size_t>(result);
+        }
+        shutdown(client, SD_BOTH);
+    }
+
+public:
+    MetricsEndpoint() : listenSocket(INVALID_SOCKET), running(false) {}
+    ~MetricsEndpoint() { stop(); }
+
+    // Listens on 127.0.0.1:port only; the numbers are for operators on the host.
+    int start(uint16_t port, std::function<std::string()> renderMetrics) {
+        listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (listenSocket == INVALID_SOCKET) {
+            return SETUP_ERROR;
+        }
+        int reuseAddr = 1;
+        setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuseAddr, sizeof(reuseAddr));
+
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        if (bind(listenSocket, (SOCKADDR*)&addr, sizeof(addr)) == SOCKET_ERROR) {
+            closesocket(listenSocket);
+            listenSocket = INVALID_SOCKET;
+            return BIND_ERROR;
+        }
+        if (listen(listenSocket, 16) == SOCKET_ERROR) {
+            closesocket(listenSocket);
+            listenSocket = INVALID_SOCKET;
+            return SETUP_ERROR;
+        }
+
+        render = std::move(renderMetrics);
+        running = true;
+        thread = std::thread([this] { serve(); });
+        return SUCCESS;
+    }
+
+    void stop() {
+        running = false;
+        if (thread.joinable()) {
+            thread.join();
+        }
+        if (listenSocket != INVALID_SOCKET) {
+            closesocket(listenSocket);
+            listenSocket = INVALID_SOCKET;
+        }
+    }
+};
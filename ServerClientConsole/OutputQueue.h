@@ -0,0 +1,170 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "ChatDirectory.h"
+#include "Frame.h"
+#include "Platform.h"
+#include "Status.h"
+
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
+
+// One gathered-write buffer: WSABUF for WSASend, iovec for sendmsg.
+#ifdef _WIN32
+typedef WSABUF IoBuffer;
+inline void setIoBuffer(IoBuffer& buffer, const char* data, size_t length) {
+    buffer.buf = const_cast<char*>(data);
+    buffer.len = static_cast<ULONG>(length);
+}
+inline size_t ioBufferLength(const IoBuffer& buffer) { return buffer.len; }
+#else
+typedef iovec IoBuffer;
+inline void setIoBuffer(IoBuffer& buffer, const char* data, size_t length) {
+    buffer.iov_base = const_cast<char*>(data);
+    buffer.iov_len = length;
+}
+inline size_t ioBufferLength(const IoBuffer& buffer) { return buffer.iov_len; }
+#endif
+
+// What to do when a recipient's queue passes the high watermark.
+enum SlowConsumerPolicy {
+    DROP_OLDEST,      // Discard the oldest unsent frames
+    DROP_CONNECTION,  // Disconnect the slow recipient
+    PAUSE_SENDER      // Stop reading from whoever is producing until the queue drains
+};
+
+struct OutputCounters {
+    std::atomic<uint64_t> framesDropped;
+    std::atomic<uint64_t> slowConsumerDisconnects;
+    std::atomic<uint64_t> senderPauses;
+
+    OutputCounters() : framesDropped(0), slowConsumerDisconnects(0), senderPauses(0) {}
+};
+
+// Outbound frames for one connection, written with gathered sends when the
+// socket is writable. Frames are shared with other recipients, never copied.
+class OutputQueue {
+private:
+    static const int MAX_GATHER = 64;
+
+    // The protocol is fixed per entry: frames queued before a hello keep the v1 bytes
+    struct QueuedFrame {
+        FramePtr frame;
+        int protocol;
+        bool droppable;   // False for frames the peer's stream state depends on (compressed ones)
+
+        const char* data() const { return frame->data(protocol); }
+        size_t size() const { return frame->size(protocol); }
+    };
+
+    std::deque<QueuedFrame> frames;
+    size_t headOffset;      // Bytes of frames.front() already written
+    size_t queuedBytes;     // Unwritten bytes across all frames
+
+public:
+    uint64_t framesDropped;
+    std::vector<UserLocation> pausedSenders;  // Senders waiting for this queue to drain
+
+    OutputQueue() : headOffset(0), queuedBytes(0), framesDropped(0) {}
+
+    bool empty() const { return frames.empty(); }
+    size_t bytes() const { return queuedBytes; }
+    size_t depth() const { return frames.size(); }
+
+    void push(const FramePtr& frame, int protocol, bool droppable = true) {
+        frames.push_back(QueuedFrame{ frame, protocol, droppable });
+        queuedBytes += frame->size(protocol);
+    }
+
+    // Drops whole frames from the front (never a partially written one, nor
+    // one pushed as not droppable) until the queue fits in limit bytes.
+    // Returns the number of frames dropped.
+    size_t dropOldest(size_t limit) {
+        size_t dropped = 0;
+        auto victim = frames.begin() + ((headOffset > 0) ? 1 : 0);
+        while (queuedBytes > limit && victim != frames.end()) {
+            if (!victim->droppable) {
+                ++victim;
+                continue;
+            }
+            queuedBytes -= victim->size();
+            victim = frames.erase(victim);
+            dropped++;
+        }
+        framesDropped += dropped;
+        return dropped;
+    }
+
+    // Fills up to max buffers with the unwritten bytes, oldest first; hand
+    // them to one gathered send and report the result through markSent.
+    size_t gather(IoBuffer* buffers, size_t max) const {
+        size_t count = 0;
+        for (auto it = frames.begin(); it != frames.end() && count < max; ++it, ++count) {
+            size_t offset = (count == 0) ? headOffset : 0;
+            setIoBuffer(buffers[count], it->data() + offset, it->size() - offset);
+        }
+        return count;
+    }
+
+    // Releases frames once sent bytes of them have been written.
+    void markSent(size_t sent) {
+        queuedBytes -= sent;
+        while (sent > 0) {
+            size_t remaining = frames.front().size() - headOffset;
+            if (sent < remaining) {
+                headOffset += sent;
+                return;
+            }
+            sent -= remaining;
+            headOffset = 0;
+            frames.pop_front();
+        }
+    }
+
+    // Writes as much as the socket accepts. Returns SUCCESS when the socket would
+    // block or the queue is empty, DISCONNECT if the peer is gone.
+    int flush(SOCKET socket) {
+        IoBuffer buffers[MAX_GATHER];
+        while (!frames.empty()) {
+            size_t count = gather(buffers, MAX_GATHER);
+#ifdef _WIN32
+            DWORD sentBytes = 0;
+            if (WSASend(socket, buffers, static_cast<DWORD>(count), &sentBytes, 0, nullptr, nullptr) == SOCKET_ERROR) {
+                return socketWouldBlock() ? SUCCESS : DISCONNECT;
+            }
+            size_t sent = sentBytes;
+#else
+            msghdr message = {};
+            message.msg_iov = buffers;
+            message.msg_iovlen = count;
+            ssize_t result = sendmsg(socket, &message, MSG_NOSIGNAL);
+            if (result < 0) {
+                return (socketWouldBlock() || socketInterrupted()) ? SUCCESS : DISCONNECT;
+            }
+            size_t sent = static_cast<size_t>(result);
+#endif
+            markSent(sent);
+        }
+        return SUCCESS;
+    }
+
+    // Appends the unwritten bytes, in order (a connection handed to another process).
+    void copyUnsent(std::string& out) const {
+        for (auto it = frames.begin(); it != frames.end(); ++it) {
+            size_t offset = (it == frames.begin()) ? headOffset : 0;
+            out.append(it->data() + offset, it->size() - offset);
+        }
+    }
+
+    void clear() {
+        frames.clear();
+        headOffset = 0;
+        queuedBytes = 0;
+    }
+};
@@ -0,0 +1,321 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// Salted, memory-hard password hashing: scrypt (RFC 7914) over an in-tree
+// SHA-256, so the server needs no crypto library. A hash costs
+// 128 * r * 2^logN bytes of memory and is meant to run on a worker thread,
+// never on an event loop.
+
+class Sha256 {
+private:
+    uint32_t state[8];
+    uint64_t totalBytes;
+    uint8_t buffer[64];
+    size_t buffered;
+
+    static uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+    void transform(const uint8_t* block) {
+        static const uint32_t K[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (static_cast<uint32_t>(block[i * 4]) << 24) | (static_cast<uint32_t>(block[i * 4 + 1]) << 16) |
+                   (static_cast<uint32_t>(block[i * 4 + 2]) << 8) | block[i * 4 + 3];
+        }
+        for (int i = 16; i < 64; i++) {
+            uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; i++) {
+            uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+            uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+
+public:
+    static const size_t DIGEST_SIZE = 32;
+
+    Sha256() {
+        static const uint32_t initial[8] = {
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+        };
+        memcpy(state, initial, sizeof(state));
+        totalBytes = 0;
+        buffered = 0;
+    }
+
+    void update(const void* data, size_t length) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        totalBytes += length;
+        while (length > 0) {
+            if (buffered == 0 && length >= 64) {
+                transform(bytes);
+                bytes += 64;
+                length -= 64;
+                continue;
+            }
+            size_t take = (64 - buffered < length) ? 64 - buffered : length;
+            memcpy(buffer + buffered, bytes, take);
+            buffered += take;
+            bytes += take;
+            length -= take;
+            if (buffered == 64) {
+                transform(buffer);
+                buffered = 0;
+            }
+        }
+    }
+
+    void finish(uint8_t digest[DIGEST_SIZE]) {
+        uint64_t bits = totalBytes * 8;
+        uint8_t padding = 0x80;
+        update(&padding, 1);
+        padding = 0;
+        while (buffered != 56) {
+            update(&padding, 1);
+        }
+        uint8_t length[8];
+        for (int i = 0; i < 8; i++) length[i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+        update(length, 8);
+        for (int i = 0; i < 8; i++) {
+            digest[i * 4] = static_cast<uint8_t>(state[i] >> 24);
+            digest[i * 4 + 1] = static_cast<uint8_t>(state[i] >> 16);
+            digest[i * 4 + 2] = static_cast<uint8_t>(state[i] >> 8);
+            digest[i * 4 + 3] = static_cast<uint8_t>(state[i]);
+        }
+    }
+};
+
+// HMAC-SHA256 (RFC 2104).
+inline void hmacSha256(const uint8_t* key, size_t keyLength, const uint8_t* data, size_t dataLength,
+                       uint8_t out[Sha256::DIGEST_SIZE]) {
+    uint8_t block[64] = {};
+    if (keyLength > 64) {
+        Sha256 keyHash;
+        keyHash.update(key, keyLength);
+        keyHash.finish(block);
+    }
+    else {
+        memcpy(block, key, keyLength);
+    }
+    uint8_t pad[64];
+    Sha256 inner, outer;
+    for (int i = 0; i < 64; i++) pad[i] = block[i] ^ 0x36;
+    inner.update(pad, 64);
+    inner.update(data, dataLength);
+    inner.finish(out);
+    for (int i = 0; i < 64; i++) pad[i] = block[i] ^ 0x5c;
+    outer.update(pad, 64);
+    outer.update(out, Sha256::DIGEST_SIZE);
+    outer.finish(out);
+}
+
+// PBKDF2-HMAC-SHA256 (RFC 8018). The keyed inner and outer states are built
+// once and copied for every block.
+inline void pbkdf2Sha256(const uint8_t* password, size_t passwordLength, const uint8_t* salt, size_t saltLength,
+                         uint32_t iterations, uint8_t* out, size_t outLength) {
+    uint8_t key[64] = {};
+    if (passwordLength > 64) {
+        Sha256 keyHash;
+        keyHash.update(password, passwordLength);
+        keyHash.finish(key);
+    }
+    else {
+        memcpy(key, password, passwordLength);
+    }
+    uint8_t pad[64];
+    Sha256 inner, outer;
+    for (int i = 0; i < 64; i++) pad[i] = key[i] ^ 0x36;
+    inner.update(pad, 64);
+    for (int i = 0; i < 64; i++) pad[i] = key[i] ^ 0x5c;
+    outer.update(pad, 64);
+
+    uint8_t u[Sha256::DIGEST_SIZE];
+    uint8_t t[Sha256::DIGEST_SIZE];
+    for (uint32_t block = 1; outLength > 0; block++) {
+        uint8_t counter[4] = { static_cast<uint8_t>(block >> 24), static_cast<uint8_t>(block >> 16),
+                               static_cast<uint8_t>(block >> 8), static_cast<uint8_t>(block) };
+        Sha256 h = inner;
+        h.update(salt, saltLength);
+        h.update(counter, 4);
+        h.finish(u);
+        h = outer;
+        h.update(u, sizeof(u));
+        h.finish(u);
+        memcpy(t, u, sizeof(t));
+        for (uint32_t i = 1; i < iterations; i++) {
+            h = inner;
+            h.update(u, sizeof(u));
+            h.finish(u);
+            h = outer;
+            h.update(u, sizeof(u));
+            h.finish(u);
+            for (size_t j = 0; j < sizeof(t); j++) t[j] ^= u[j];
+        }
+        size_t take = (outLength < sizeof(t)) ? outLength : sizeof(t);
+        memcpy(out, t, take);
+        out += take;
+        outLength -= take;
+    }
+}
+
+inline void salsa20_8(uint32_t b[16]) {
+    uint32_t x[16];
+    memcpy(x, b, sizeof(x));
+#define SALSA_R(a, n) (((a) << (n)) | ((a) >> (32 - (n))))
+    for (int i = 0; i < 8; i += 2) {
+        x[4] ^= SALSA_R(x[0] + x[12], 7);  x[8] ^= SALSA_R(x[4] + x[0], 9);
+        x[12] ^= SALSA_R(x[8] + x[4], 13); x[0] ^= SALSA_R(x[12] + x[8], 18);
+        x[9] ^= SALSA_R(x[5] + x[1], 7);   x[13] ^= SALSA_R(x[9] + x[5], 9);
+        x[1] ^= SALSA_R(x[13] + x[9], 13); x[5] ^= SALSA_R(x[1] + x[13], 18);
+        x[14] ^= SALSA_R(x[10] + x[6], 7); x[2] ^= SALSA_R(x[14] + x[10], 9);
+        x[6] ^= SALSA_R(x[2] + x[14], 13); x[10] ^= SALSA_R(x[6] + x[2], 18);
+        x[3] ^= SALSA_R(x[15] + x[11], 7); x[7] ^= SALSA_R(x[3] + x[15], 9);
+        x[11] ^= SALSA_R(x[7] + x[3], 13); x[15] ^= SALSA_R(x[11] + x[7], 18);
+        x[1] ^= SALSA_R(x[0] + x[3], 7);   x[2] ^= SALSA_R(x[1] + x[0], 9);
+        x[3] ^= SALSA_R(x[2] + x[1], 13);  x[0] ^= SALSA_R(x[3] + x[2], 18);
+        x[6] ^= SALSA_R(x[5] + x[4], 7);   x[7] ^= SALSA_R(x[6] + x[5], 9);
+        x[4] ^= SALSA_R(x[7] + x[6], 13);  x[5] ^= SALSA_R(x[4] + x[7], 18);
+        x[11] ^= SALSA_R(x[10] + x[9], 7); x[8] ^= SALSA_R(x[11] + x[10], 9);
+        x[9] ^= SALSA_R(x[8] + x[11], 13); x[10] ^= SALSA_R(x[9] + x[8], 18);
+        x[12] ^= SALSA_R(x[15] + x[14], 7); x[13] ^= SALSA_R(x[12] + x[15], 9);
+        x[14] ^= SALSA_R(x[13] + x[12], 13); x[15] ^= SALSA_R(x[14] + x[13], 18);
+    }
+#undef SALSA_R
+    for (int i = 0; i < 16; i++) b[i] += x[i];
+}
+
+// scrypt BlockMix over 2r 64-byte blocks; y is scratch of the same size.
+inline void scryptBlockMix(uint32_t* b, uint32_t* y, uint32_t r) {
+    uint32_t x[16];
+    memcpy(x, &b[(2 * r - 1) * 16], 64);
+    for (uint32_t i = 0; i < 2 * r; i++) {
+        for (int k = 0; k < 16; k++) x[k] ^= b[i * 16 + k];
+        salsa20_8(x);
+        // Even blocks go to the first half, odd blocks to the second
+        memcpy(&y[((i & 1) * r + i / 2) * 16], x, 64);
+    }
+    memcpy(b, y, 128 * r);
+}
+
+inline void scryptROMix(uint8_t* block, uint32_t r, uint64_t n, std::vector<uint32_t>& memory) {
+    size_t words = 32 * r;
+    memory.resize(words * (n + 2));
+    uint32_t* v = memory.data();
+    uint32_t* x = v + words * n;
+    uint32_t* y = x + words;
+    for (size_t k = 0; k < words; k++) {
+        const uint8_t* p = block + 4 * k;
+        x[k] = p[0] | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+    for (uint64_t i = 0; i < n; i++) {
+        memcpy(&v[i * words], x, words * 4);
+        scryptBlockMix(x, y, r);
+    }
+    for (uint64_t i = 0; i < n; i++) {
+        uint64_t j = x[(2 * r - 1) * 16] & (n - 1);
+        for (size_t k = 0; k < words; k++) x[k] ^= v[j * words + k];
+        scryptBlockMix(x, y, r);
+    }
+    for (size_t k = 0; k < words; k++) {
+        uint8_t* p = block + 4 * k;
+        p[0] = static_cast<uint8_t>(x[k]);
+        p[1] = static_cast<uint8_t>(x[k] >> 8);
+        p[2] = static_cast<uint8_t>(x[k] >> 16);
+        p[3] = static_cast<uint8_t>(x[k] >> 24);
+    }
+}
+
+inline void scrypt(const std::string& password, const uint8_t* salt, size_t saltLength,
+                   int logN, uint32_t r, uint32_t p, uint8_t* out, size_t outLength) {
+    const uint8_t* passwordBytes = reinterpret_cast<const uint8_t*>(password.data());
+    size_t blockSize = 128 * static_cast<size_t>(r);
+    std::vector<uint8_t> blocks(blockSize * p);
+    pbkdf2Sha256(passwordBytes, password.size(), salt, saltLength, 1, blocks.data(), blocks.size());
+    std::vector<uint32_t> memory;
+    for (uint32_t i = 0; i < p; i++) {
+        scryptROMix(&blocks[i * blockSize], r, 1ULL << logN, memory);
+    }
+    pbkdf2Sha256(passwordBytes, password.size(), blocks.data(), blocks.size(), 1, out, outLength);
+}
+
+// What the user store keeps per account instead of the password.
+struct Credential {
+    static const size_t SALT_SIZE = 16;
+    static const size_t HASH_SIZE = 32;
+
+    uint8_t logN;    // scrypt parameters, kept per account so the cost can change later
+    uint8_t r;
+    uint8_t p;
+    uint8_t salt[SALT_SIZE];
+    uint8_t hash[HASH_SIZE];
+};
+
+// The parameters --kdf-cost can produce, and the only ones a stored or
+// replicated credential may carry: anything else could ask for more memory
+// than the machine has, or shift 1 past 63 bits.
+static const int KDF_MIN_LOG_N = 1;
+static const int KDF_MAX_LOG_N = 24;
+static const int KDF_MAX_R_TIMES_P = 64;
+static const uint64_t KDF_MAX_MEMORY = 128ull * 8 << KDF_MAX_LOG_N;   // The default r at the highest cost
+
+inline bool validKdfParameters(int logN, int r, int p) {
+    return logN >= KDF_MIN_LOG_N && logN <= KDF_MAX_LOG_N && r >= 1 && p >= 1 && r * p <= KDF_MAX_R_TIMES_P &&
+           (128ull * static_cast<uint64_t>(r)) << logN <= KDF_MAX_MEMORY;
+}
+
+struct KdfOptions {
+    int logN;
+    int r;
+    int p;
+
+    KdfOptions() : logN(14), r(8), p(1) {}   // 16 MiB per hash
+};
+
+inline Credential hashPassword(const std::string& password, const KdfOptions& options) {
+    Credential credential;
+    credential.logN = static_cast<uint8_t>(options.logN);
+    credential.r = static_cast<uint8_t>(options.r);
+    credential.p = static_cast<uint8_t>(options.p);
+    std::random_device random;
+    for (size_t i = 0; i < Credential::SALT_SIZE; i += 4) {
+        uint32_t value = random();
+        memcpy(credential.salt + i, &value, 4);
+    }
+    scrypt(password, credential.salt, Credential::SALT_SIZE, credential.logN, credential.r, credential.p,
+        credential.hash, Credential::HASH_SIZE);
+    return credential;
+}
+
+inline bool verifyPassword(const std::string& password, const Credential& credential) {
+    uint8_t hash[Credential::HASH_SIZE];
+    scrypt(password, credential.salt, Credential::SALT_SIZE, credential.logN, credential.r, credential.p,
+        hash, Credential::HASH_SIZE);
+    uint8_t difference = 0;   // Constant time: no early exit on the first mismatch
+    for (size_t i = 0; i < Credential::HASH_SIZE; i++) {
+        difference |= hash[i] ^ credential.hash[i];
+    }
+    return difference == 0;
+}
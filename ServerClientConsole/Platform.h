@@ -0,0 +1,143 @@
+#pragma once
+
+// Thin socket portability layer so the same server code builds with Winsock
+// (Visual Studio project) and BSD sockets (CMake build on Linux).
+
+#ifdef _WIN32
+
+#include <WS2tcpip.h>
+#include <winsock2.h>
+#pragma comment(lib, "ws2_32.lib")
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+typedef int socklen_t;
+
+inline int initSockets() {
+    WSADATA wsaData;
+    return WSAStartup(MAKEWORD(2, 2), &wsaData);
+}
+
+inline void cleanupSockets() {
+    WSACleanup();
+}
+
+inline int lastSocketError() {
+    return WSAGetLastError();
+}
+
+inline bool socketWouldBlock() {
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+}
+
+inline bool socketInterrupted() {
+    return WSAGetLastError() == WSAEINTR;
+}
+
+inline int setNonBlocking(SOCKET s) {
+    u_long mode = 1;
+    return ioctlsocket(s, FIONBIO, &mode);
+}
+
+inline int socketPoll(WSAPOLLFD* fds, unsigned long count, int timeoutMs) {
+    return WSAPoll(fds, count, timeoutMs);
+}
+
+typedef WSAPOLLFD pollfd;
+
+// Connected loopback pair used to wake a blocked poller from another thread.
+inline int createSocketPair(SOCKET pair[2]) {
+    SOCKET listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener == INVALID_SOCKET) return SOCKET_ERROR;
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    int addrLen = sizeof(addr);
+
+    pair[0] = pair[1] = INVALID_SOCKET;
+    if (bind(listener, (SOCKADDR*)&addr, sizeof(addr)) == SOCKET_ERROR ||
+        getsockname(listener, (SOCKADDR*)&addr, &addrLen) == SOCKET_ERROR ||
+        listen(listener, 1) == SOCKET_ERROR) {
+        closesocket(listener);
+        return SOCKET_ERROR;
+    }
+
+    pair[1] = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (pair[1] == INVALID_SOCKET ||
+        connect(pair[1], (SOCKADDR*)&addr, sizeof(addr)) == SOCKET_ERROR) {
+        closesocket(listener);
+        if (pair[1] != INVALID_SOCKET) closesocket(pair[1]);
+        return SOCKET_ERROR;
+    }
+
+    pair[0] = accept(listener, nullptr, nullptr);
+    closesocket(listener);
+    if (pair[0] == INVALID_SOCKET) {
+        closesocket(pair[1]);
+        return SOCKET_ERROR;
+    }
+    return 0;
+}
+
+#else
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+typedef int SOCKET;
+typedef sockaddr SOCKADDR;
+
+#define INVALID_SOCKET (-1)
+#define SOCKET_ERROR (-1)
+#define SD_BOTH SHUT_RDWR
+
+inline int initSockets() {
+    return 0;
+}
+
+inline void cleanupSockets() {}
+
+inline int closesocket(SOCKET s) {
+    return close(s);
+}
+
+inline int lastSocketError() {
+    return errno;
+}
+
+inline bool socketWouldBlock() {
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+inline bool socketInterrupted() {
+    return errno == EINTR;
+}
+
+inline int setNonBlocking(SOCKET s) {
+    int flags = fcntl(s, F_GETFL, 0);
+    if (flags < 0) return SOCKET_ERROR;
+    return fcntl(s, F_SETFL, flags | O_NONBLOCK);
+}
+
+inline int socketPoll(pollfd* fds, unsigned long count, int timeoutMs) {
+    return poll(fds, static_cast<nfds_t>(count), timeoutMs);
+}
+
+// Connected pair used to wake a blocked poller from another thread.
+inline int createSocketPair(SOCKET pair[2]) {
+    return socketpair(AF_UNIX, SOCK_STREAM, 0, pair);
+}
+
+#endif
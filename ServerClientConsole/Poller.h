@@ -0,0 +1,219 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Platform.h"
+#include "Status.h"
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+enum PollerEvents : uint32_t {
+    POLLER_READ = 1u << 0,
+    POLLER_WRITE = 1u << 1,
+    POLLER_ERROR = 1u << 2
+};
+
+struct PollEvent {
+    uint64_t token;   // Caller-supplied at registration; identifies the source without a lookup
+    uint32_t events;
+};
+
+// Readiness notification backend used by the server event loop.
+class Poller {
+public:
+    virtual ~Poller() {}
+
+    virtual const char* name() const = 0;
+
+    // Edge-triggered backends report a socket only when its state changes, so
+    // callers must drain reads/accepts until the socket would block.
+    virtual bool edgeTriggered() const = 0;
+
+    virtual int add(SOCKET socket, uint32_t events, uint64_t token) = 0;
+    virtual int modify(SOCKET socket, uint32_t events, uint64_t token) = 0;
+    virtual int remove(SOCKET socket) = 0;
+
+    // Blocks until a registered socket is ready or timeoutMs elapses (-1 waits forever).
+    virtual int wait(std::vector<PollEvent>& ready, int timeoutMs) = 0;
+};
+
+// Portable level-triggered fallback. Limited to FD_SETSIZE sockets and O(n) per wakeup.
+class SelectPoller : public Poller {
+private:
+    struct Entry {
+        SOCKET socket;
+        uint32_t events;
+        uint64_t token;
+    };
+
+    std::vector<Entry> entries;
+    std::unordered_map<SOCKET, size_t> entryIndex;  // Socket -> position in entries
+
+public:
+    const char* name() const override { return "select"; }
+    bool edgeTriggered() const override { return false; }
+
+    int add(SOCKET socket, uint32_t events, uint64_t token) override {
+#ifdef _WIN32
+        if (entries.size() >= FD_SETSIZE) return CAPACITY_ERROR;
+#else
+        if (socket >= FD_SETSIZE) return CAPACITY_ERROR;
+#endif
+        entryIndex[socket] = entries.size();
+        entries.push_back({ socket, events, token });
+        return SUCCESS;
+    }
+
+    int modify(SOCKET socket, uint32_t events, uint64_t token) override {
+        auto it = entryIndex.find(socket);
+        if (it == entryIndex.end()) return PARAMETER_ERROR;
+        entries[it->second].events = events;
+        entries[it->second].token = token;
+        return SUCCESS;
+    }
+
+    int remove(SOCKET socket) override {
+        auto it = entryIndex.find(socket);
+        if (it == entryIndex.end()) return PARAMETER_ERROR;
+
+        size_t index = it->second;
+        entryIndex.erase(it);
+        if (index != entries.size() - 1) {
+            entries[index] = entries.back();
+            entryIndex[entries[index].socket] = index;
+        }
+        entries.pop_back();
+        return SUCCESS;
+    }
+
+    int wait(std::vector<PollEvent>& ready, int timeoutMs) override {
+        ready.clear();
+
+        fd_set readSet;
+        fd_set writeSet;
+        FD_ZERO(&readSet);
+        FD_ZERO(&writeSet);
+
+        SOCKET maxSocket = 0;
+        for (const Entry& entry : entries) {
+            if (entry.events & POLLER_READ) FD_SET(entry.socket, &readSet);
+            if (entry.events & POLLER_WRITE) FD_SET(entry.socket, &writeSet);
+            if (entry.socket > maxSocket) maxSocket = entry.socket;
+        }
+
+        timeval timeout;
+        timeout.tv_sec = timeoutMs / 1000;
+        timeout.tv_usec = (timeoutMs % 1000) * 1000;
+
+        int selectResult = select(static_cast<int>(maxSocket + 1), &readSet, &writeSet, nullptr,
+            timeoutMs < 0 ? nullptr : &timeout);
+        if (selectResult == SOCKET_ERROR) {
+            return socketInterrupted() ? SUCCESS : SELECT_ERROR;
+        }
+
+        for (const Entry& entry : entries) {
+            uint32_t events = 0;
+            if (FD_ISSET(entry.socket, &readSet)) events |= POLLER_READ;
+            if (FD_ISSET(entry.socket, &writeSet)) events |= POLLER_WRITE;
+            if (events != 0) ready.push_back({ entry.token, events });
+        }
+        return SUCCESS;
+    }
+};
+
+#ifdef __linux__
+
+// Edge-triggered epoll backend: O(ready) per wakeup and no descriptor ceiling.
+class EpollPoller : public Poller {
+private:
+    int epollFd;
+    std::vector<epoll_event> events;
+
+    static uint32_t toEpoll(uint32_t events) {
+        uint32_t result = EPOLLET | EPOLLRDHUP;
+        if (events & POLLER_READ) result |= EPOLLIN;
+        if (events & POLLER_WRITE) result |= EPOLLOUT;
+        return result;
+    }
+
+    int control(int op, SOCKET socket, uint32_t events, uint64_t token) {
+        epoll_event ev = {};
+        ev.events = toEpoll(events);
+        ev.data.u64 = token;
+        return (epoll_ctl(epollFd, op, socket, &ev) == 0) ? SUCCESS : SELECT_ERROR;
+    }
+
+public:
+    EpollPoller() : epollFd(epoll_create1(EPOLL_CLOEXEC)), events(256) {}
+
+    ~EpollPoller() override {
+        if (epollFd >= 0) close(epollFd);
+    }
+
+    bool valid() const { return epollFd >= 0; }
+
+    const char* name() const override { return "epoll"; }
+    bool edgeTriggered() const override { return true; }
+
+    int add(SOCKET socket, uint32_t events, uint64_t token) override {
+        return control(EPOLL_CTL_ADD, socket, events, token);
+    }
+
+    int modify(SOCKET socket, uint32_t events, uint64_t token) override {
+        return control(EPOLL_CTL_MOD, socket, events, token);
+    }
+
+    int remove(SOCKET socket) override {
+        return control(EPOLL_CTL_DEL, socket, 0, 0);
+    }
+
+    int wait(std::vector<PollEvent>& ready, int timeoutMs) override {
+        ready.clear();
+
+        int count = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), timeoutMs);
+        if (count < 0) {
+            return (errno == EINTR) ? SUCCESS : SELECT_ERROR;
+        }
+
+        for (int i = 0; i < count; i++) {
+            uint32_t flags = 0;
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP)) flags |= POLLER_READ;
+            if (events[i].events & EPOLLOUT) flags |= POLLER_WRITE;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) flags |= POLLER_ERROR | POLLER_READ;
+            ready.push_back({ events[i].data.u64, flags });
+        }
+
+        // A full batch means more sockets may be waiting; grow so the next wakeup takes them all.
+        if (count == static_cast<int>(events.size())) {
+            events.resize(events.size() * 2);
+        }
+        return SUCCESS;
+    }
+};
+
+#endif
+
+inline const char* defaultPollerType() {
+#ifdef __linux__
+    return "epoll";
+#else
+    return "select";
+#endif
+}
+
+// Creates the requested backend, falling back to select() where it is unavailable.
+inline std::unique_ptr<Poller> createPoller(const std::string& type) {
+#ifdef __linux__
+    if (type == "epoll") {
+        std::unique_ptr<EpollPoller> poller(new EpollPoller());
+        if (poller->valid()) return poller;
+    }
+#endif
+    return std::unique_ptr<Poller>(new SelectPoller());
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// What a client's traffic is charged against. Every message costs one
+// RATE_MESSAGES token and its length in RATE_BYTES; ~register/~login and
+// the blocking commands also draw on budgets of their own.
+enum RateBucket {
+    RATE_MESSAGES,
+    RATE_BYTES,
+    RATE_AUTH,     // ~register, ~login: password hashing is expensive
+    RATE_HEAVY,    // Commands run on the executor (~getlog)
+    RATE_BUCKETS
+};
+
+inline const char* rateBucketName(int bucket) {
+    static const char* names[RATE_BUCKETS] = { "messages", "bytes", "auth", "heavy" };
+    return names[bucket];
+}
+
+struct RateLimit {
+    uint32_t perSecond;   // 0 = unlimited
+    uint32_t burst;       // Bucket size: what an idle client may send at once
+
+    RateLimit(uint32_t perSecond = 0, uint32_t burst = 0) : perSecond(perSecond), burst(burst) {}
+
+    // "RATE" or "RATE:BURST"; the burst defaults to twice the rate.
+    static RateLimit parse(const char* text) {
+        char* end;
+        uint32_t rate = static_cast<uint32_t>(std::strtoul(text, &end, 10));
+        uint32_t burst = (*end == ':') ? static_cast<uint32_t>(std::strtoul(end + 1, nullptr, 10)) : rate * 2;
+        return RateLimit(rate, (burst > 0) ? burst : rate);
+    }
+};
+
+inline uint64_t monotonicMillis() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Token bucket counted in thousandths of a token, so a refill of perSecond
+// tokens a second is perSecond units a millisecond with no rounding. The
+// limit is passed in rather than stored: every connection shares the
+// configured ones and a bucket stays two words.
+class TokenBucket {
+private:
+    uint64_t milliTokens;
+    uint64_t lastRefill;   // monotonicMillis()
+
+    void refill(const RateLimit& limit, uint64_t now) {
+        uint64_t full = static_cast<uint64_t>(limit.burst) * 1000;
+        uint64_t gained = (now > lastRefill) ? (now - lastRefill) * limit.perSecond : 0;
+        lastRefill = (now > lastRefill) ? now : lastRefill;
+        milliTokens = (milliTokens >= full || full - milliTokens <= gained) ? full : milliTokens + gained;
+    }
+
+    static uint64_t costOf(const RateLimit& limit, uint64_t cost) {
+        // Anything larger than the bucket costs a full bucket, or it would never fit
+        return ((cost < limit.burst) ? cost : limit.burst) * 1000;
+    }
+
+public:
+    TokenBucket() : milliTokens(UINT64_MAX), lastRefill(0) {}   // Starts full
+
+    // Milliseconds until cost tokens are available; 0 if they are now.
+    uint64_t waitFor(const RateLimit& limit, uint64_t cost, uint64_t now) {
+        if (limit.perSecond == 0) {
+            return 0;
+        }
+        refill(limit, now);
+        uint64_t needed = costOf(limit, cost);
+        return (milliTokens >= needed) ? 0 : (needed - milliTokens + limit.perSecond - 1) / limit.perSecond;
+    }
+
+    // Only after waitFor() said the tokens are there.
+    void take(const RateLimit& limit, uint64_t cost) {
+        if (limit.perSecond != 0) {
+            milliTokens -= costOf(limit, cost);
+        }
+    }
+
+    bool full(const RateLimit& limit, uint64_t now) {
+        return waitFor(limit, limit.burst, now) == 0;
+    }
+};
+
+// Message and byte buckets of users who logged out with a partly drained
+// budget, so reconnecting does not buy a fresh one. Touched on login and
+// logout only; the hot path works on the connection's own copy.
+class UserRateStates {
+private:
+    struct Saved {
+        TokenBucket messages;
+        TokenBucket bytes;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<std::string, Saved> users;
+
+public:
+    void save(const std::string& username, const TokenBucket& messages, const TokenBucket& bytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        users[username] = Saved{ messages, bytes };
+    }
+
+    // Leaves the buckets alone if nothing was saved for the user.
+    void restore(const std::string& username, TokenBucket& messages, TokenBucket& bytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = users.find(username);
+        if (it != users.end()) {
+            messages = it->second.messages;
+            bytes = it->second.bytes;
+            users.erase(it);
+        }
+    }
+};
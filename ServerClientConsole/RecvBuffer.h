@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "BufferPool.h"
+
+// Per-connection receive buffer: a pointer and three offsets, with storage
+// attached only while bytes are pending. A read goes into the reactor's
+// scratch block, lent to the connection with borrow(); complete frames are
+// parsed in place there and settle() moves only what is left (at most one
+// partial frame, or frames a pause held back) into a block of the
+// connection's own from the pool. An idle connection holds no storage.
+class RecvBuffer {
+private:
+    static const int8_t BORROWED = -1;   // sizeClass of the reactor's scratch block
+    static const int8_t DETACHED = -2;
+
+    char* storage;
+    uint32_t capacity;
+    uint32_t head;    // First unconsumed byte
+    uint32_t tail;    // One past the last received byte
+    int8_t sizeClass;
+
+    // Moves the pending bytes into a pool block holding at least size bytes.
+    void moveTo(BufferPool& pool, size_t size) {
+        size = (size < BufferPool::largestBlock()) ? size : BufferPool::largestBlock();   // Never less than pending
+        int target = BufferPool::classFor(size);
+        size_t pending = tail - head;
+        char* block = pool.allocate(target);
+        memcpy(block, storage + head, pending);
+        if (sizeClass >= 0) {
+            pool.release(storage, sizeClass);
+        }
+        storage = block;
+        capacity = static_cast<uint32_t>(BufferPool::classSize(target));
+        sizeClass = static_cast<int8_t>(target);
+        head = 0;
+        tail = static_cast<uint32_t>(pending);
+    }
+
+public:
+    RecvBuffer() : storage(nullptr), capacity(0), head(0), tail(0), sizeClass(DETACHED) {}
+
+    bool attached() const { return storage != nullptr; }
+    bool borrowed() const { return sizeClass == BORROWED; }
+
+    const char* readPtr() const { return storage + head; }
+    size_t readable() const { return tail - head; }
+
+    char* writePtr() { return storage + tail; }
+    size_t writable() const { return capacity - tail; }
+
+    void produce(size_t count) { tail += static_cast<uint32_t>(count); }
+
+    void consume(size_t count) {
+        head += static_cast<uint32_t>(count);
+        if (head == tail) {
+            head = tail = 0;
+        }
+    }
+
+    // Reads into the scratch block until settle(); only while detached.
+    void borrow(char* scratch, size_t size) {
+        storage = scratch;
+        capacity = static_cast<uint32_t>(size);
+        head = tail = 0;
+        sizeClass = BORROWED;
+    }
+
+    // Done parsing for now: drops the storage if nothing is pending, and
+    // copies what is left out of a borrowed scratch block.
+    void settle(BufferPool& pool, size_t readRoom) {
+        if (head == tail) {
+            release(pool);
+        }
+        else if (sizeClass == BORROWED) {
+            moveTo(pool, tail - head + readRoom);
+        }
+    }
+
+    // Grows the buffer (compacting it) so a frame of frameSize bytes fits.
+    void reserve(BufferPool& pool, size_t frameSize) {
+        if (frameSize > capacity - head) {
+            moveTo(pool, frameSize);
+        }
+    }
+
+    // Makes room at the tail by sliding the pending partial frame to the front.
+    void compact() {
+        if (head == 0) return;
+        size_t pending = tail - head;
+        memmove(storage, storage + head, pending);
+        head = 0;
+        tail = static_cast<uint32_t>(pending);
+    }
+
+    void release(BufferPool& pool) {
+        if (sizeClass >= 0) {
+            pool.release(storage, sizeClass);
+        }
+        storage = nullptr;
+        capacity = head = tail = 0;
+        sizeClass = DETACHED;
+    }
+};
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "SlotMap.h"
+#include "Status.h"
+
+// Room 0 is the lobby: every logged-in connection, the audience of public
+// messages. Room 1 holds the connections that asked for presence notices.
+// Named rooms (#name) get ids from the RoomDirectory.
+static const uint32_t LOBBY_ROOM = 0;
+static const uint32_t PRESENCE_ROOM = 1;
+static const uint32_t FIRST_NAMED_ROOM = 2;
+static const size_t MAX_ROOM_NAME_LENGTH = 32;
+
+// "#" followed by letters, digits, '-' or '_'.
+inline bool validRoomName(std::string_view name) {
+    if (name.size() < 2 || name.size() > MAX_ROOM_NAME_LENGTH + 1 || name[0] != '#') {
+        return false;
+    }
+    for (char c : name.substr(1)) {
+        bool word = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_';
+        if (!word) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Room names and ids shared by every reactor, plus how many members each room
+// has on each reactor, so a message is only posted to reactors that have
+// someone to deliver it to. Ids are never reused: a fan-out still in some
+// mailbox can never land in a different room.
+class RoomDirectory {
+private:
+    struct Room {
+        std::string name;
+        std::vector<uint32_t> members;   // Per reactor
+        uint32_t total;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<Room> rooms;   // Ids below FIRST_NAMED_ROOM stand in for the built-in rooms and are never handed out
+    size_t reactorCount;
+    size_t maxRooms;
+
+public:
+    RoomDirectory() : rooms(FIRST_NAMED_ROOM), reactorCount(1), maxRooms(0) {}
+
+    void configure(size_t reactors, size_t maxRooms) {
+        std::lock_guard<std::mutex> lock(mutex);
+        reactorCount = reactors;
+        this->maxRooms = maxRooms;
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return rooms.size() - FIRST_NAMED_ROOM;
+    }
+
+    // Creates the room on first use. CAPACITY_ERROR once maxRooms names exist.
+    int join(const std::string& name, int reactorId, uint32_t& room, uint32_t& total) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = ids.find(name);
+        if (it == ids.end()) {
+            if (maxRooms > 0 && rooms.size() - FIRST_NAMED_ROOM >= maxRooms) {
+                return CAPACITY_ERROR;
+            }
+            it = ids.emplace(name, static_cast<uint32_t>(rooms.size())).first;
+            rooms.push_back(Room{ name, std::vector<uint32_t>(reactorCount, 0), 0 });
+        }
+        room = it->second;
+        rooms[room].members[reactorId]++;
+        total = ++rooms[room].total;
+        return SUCCESS;
+    }
+
+    void part(uint32_t room, int reactorId) {
+        std::lock_guard<std::mutex> lock(mutex);
+        rooms[room].members[reactorId]--;
+        rooms[room].total--;
+    }
+
+    bool find(const std::string& name, uint32_t& room) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = ids.find(name);
+        if (it == ids.end()) {
+            return false;
+        }
+        room = it->second;
+        return true;
+    }
+
+    std::string name(uint32_t room) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return rooms[room].name;
+    }
+
+    // Reactors with at least one member of the room.
+    void reactorsWith(uint32_t room, std::vector<int>& reactors) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const std::vector<uint32_t>& members = rooms[room].members;
+        for (size_t i = 0; i < members.size(); i++) {
+            if (members[i] > 0) {
+                reactors.push_back(static_cast<int>(i));
+            }
+        }
+    }
+};
+
+// Where a connection sits in one room's member array.
+struct RoomMembership {
+    uint32_t room;
+    uint32_t position;
+};
+
+// One reactor's subscriber index: a dense member array per room, so fan-out
+// walks only the room's members. Members remember their position; leaving
+// moves the last member into the gap, so join and part are O(1).
+class RoomIndex {
+private:
+    std::vector<std::vector<SlotHandle>> rooms;   // Indexed by room id
+
+public:
+    const std::vector<SlotHandle>& members(uint32_t room) const {
+        static const std::vector<SlotHandle> none;
+        return (room < rooms.size()) ? rooms[room] : none;
+    }
+
+    uint32_t add(uint32_t room, SlotHandle handle) {
+        if (room >= rooms.size()) {
+            rooms.resize(room + 1);
+        }
+        rooms[room].push_back(handle);
+        return static_cast<uint32_t>(rooms[room].size() - 1);
+    }
+
+    // Returns the member moved into position (whose membership must be
+    // updated), or INVALID_HANDLE if the removed one was last.
+    SlotHandle remove(uint32_t room, uint32_t position) {
+        std::vector<SlotHandle>& members = rooms[room];
+        SlotHandle moved = members.back();
+        members[position] = moved;
+        members.pop_back();
+        return (position < members.size()) ? moved : INVALID_HANDLE;
+    }
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+// Everyone online, here and on peer nodes, in name order with each ~getlist
+// line already formatted. Logins, logouts and peer presence update it one
+// entry at a time, and a query reads one page from a name onwards, so
+// ~getlist costs the page it shows rather than the number online. Changes are
+// also kept as deltas while any client has asked for presence notices.
+// Shared by every reactor.
+class Roster {
+private:
+    struct Entry {
+        std::string node;   // Empty for our own users
+        std::string line;   // "- alice\n", "- bob (on node-b)\n"
+    };
+
+    mutable std::mutex mutex;
+    std::map<std::string, Entry, std::less<>> users;
+    std::string deltas;   // "+ alice\n- bob\n" since the last takeDeltas()
+
+    // Called locked. True if this is the first delta since the last take.
+    bool noteChange(char sign, const std::string& username, const std::string& node) {
+        if (watchers.load() == 0) {
+            return false;
+        }
+        bool first = deltas.empty();
+        deltas += sign;
+        deltas += ' ';
+        deltas += username;
+        if (!node.empty()) {
+            deltas += " (on " + node + ")";
+        }
+        deltas += '\n';
+        return first;
+    }
+
+public:
+    std::atomic<size_t> watchers;   // Connections that asked for presence notices
+
+    Roster() : watchers(0) {}
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return users.size();
+    }
+
+    // Both return true when they leave the first pending delta: the caller
+    // schedules a takeDeltas(). A user seen on a new node replaces the old
+    // entry; going offline from a node the user has since left is ignored.
+    bool online(const std::string& username, const std::string& node) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry& entry = users[username];
+        if (!entry.line.empty() && entry.node == node) {
+            return false;
+        }
+        entry.node = node;
+        entry.line = "- " + username + (node.empty() ? "" : " (on " + node + ")") + "\n";
+        return noteChange('+', username, node);
+    }
+
+    bool offline(const std::string& username, const std::string& node) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = users.find(username);
+        if (it == users.end() || it->second.node != node) {
+            return false;
+        }
+        users.erase(it);
+        return noteChange('-', username, node);
+    }
+
+    std::string takeDeltas() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string taken;
+        taken.swap(deltas);
+        return taken;
+    }
+
+    // Appends up to count lines for names starting with prefix, from the first
+    // one after `after` (or from the start). If more match, next is set to the
+    // last name shown, to continue from. Returns the number of lines appended.
+    size_t page(std::string_view prefix, std::string_view after, size_t count, std::string& out, std::string& next) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = (after.empty() || after < prefix) ? users.lower_bound(prefix) : users.upper_bound(after);
+        size_t shown = 0;
+        for (; it != users.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            if (shown == count) {
+                next = std::prev(it)->first;
+                break;
+            }
+            out += it->second.line;
+            shown++;
+        }
+        return shown;
+    }
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Stable reference to a SlotMap entry: slot index in the low 32 bits, slot
+// generation in the high 32. Generations start at 1, so no handle is ever
+// below 2^32 and callers may use that range for their own tokens.
+typedef uint64_t SlotHandle;
+static const SlotHandle INVALID_HANDLE = 0;
+
+// Generational slot map. Values live in a dense array (iteration touches only
+// live entries); handles go through a slot table, so insert, lookup and erase
+// are O(1) and a handle to an erased entry never resolves to its successor.
+template <typename T>
+class SlotMap {
+private:
+    static const uint32_t NO_SLOT = 0xFFFFFFFFu;
+
+    struct Slot {
+        uint32_t generation;   // Bumped on erase; stale handles stop matching
+        uint32_t denseIndex;   // Position in values, or the next free slot while unused
+    };
+
+    std::vector<Slot> slots;
+    std::vector<T> values;
+    std::vector<uint32_t> denseToSlot;  // Owning slot of each value
+    uint32_t freeHead;
+
+    static SlotHandle makeHandle(uint32_t slotIndex, uint32_t generation) {
+        return (static_cast<uint64_t>(generation) << 32) | slotIndex;
+    }
+
+    const Slot* find(SlotHandle handle) const {
+        uint32_t slotIndex = static_cast<uint32_t>(handle);
+        uint32_t generation = static_cast<uint32_t>(handle >> 32);
+        if (generation == 0 || slotIndex >= slots.size() || slots[slotIndex].generation != generation) {
+            return nullptr;
+        }
+        return &slots[slotIndex];
+    }
+
+public:
+    SlotMap() : freeHead(NO_SLOT) {}
+
+    size_t size() const { return values.size(); }
+    bool empty() const { return values.empty(); }
+
+    template <typename... Args>
+    SlotHandle emplace(Args&&... args) {
+        uint32_t slotIndex;
+        if (freeHead != NO_SLOT) {
+            slotIndex = freeHead;
+            freeHead = slots[slotIndex].denseIndex;
+        }
+        else {
+            slotIndex = static_cast<uint32_t>(slots.size());
+            slots.push_back({ 1, 0 });
+        }
+        values.emplace_back(std::forward<Args>(args)...);
+        denseToSlot.push_back(slotIndex);
+        slots[slotIndex].denseIndex = static_cast<uint32_t>(values.size() - 1);
+        return makeHandle(slotIndex, slots[slotIndex].generation);
+    }
+
+    // Null if the handle is stale or was never issued.
+    T* get(SlotHandle handle) {
+        const Slot* slot = find(handle);
+        return slot ? &values[slot->denseIndex] : nullptr;
+    }
+
+    bool contains(SlotHandle handle) const { return find(handle) != nullptr; }
+
+    // Moves the last value into the hole; handles to it stay valid.
+    bool erase(SlotHandle handle) {
+        if (!find(handle)) {
+            return false;
+        }
+        uint32_t slotIndex = static_cast<uint32_t>(handle);
+        uint32_t denseIndex = slots[slotIndex].denseIndex;
+        uint32_t last = static_cast<uint32_t>(values.size() - 1);
+        if (denseIndex != last) {
+            values[denseIndex] = std::move(values[last]);
+            denseToSlot[denseIndex] = denseToSlot[last];
+            slots[denseToSlot[denseIndex]].denseIndex = denseIndex;
+        }
+        values.pop_back();
+        denseToSlot.pop_back();
+
+        Slot& slot = slots[slotIndex];
+        slot.generation = (slot.generation == 0xFFFFFFFFu) ? 1 : slot.generation + 1;
+        slot.denseIndex = freeHead;
+        freeHead = slotIndex;
+        return true;
+    }
+
+    void clear() {
+        while (!values.empty()) {
+            erase(handleAt(values.size() - 1));
+        }
+    }
+
+    // Dense access for iteration; positions change when entries are erased.
+    T& at(size_t denseIndex) { return values[denseIndex]; }
+    SlotHandle handleAt(size_t denseIndex) const {
+        uint32_t slotIndex = denseToSlot[denseIndex];
+        return makeHandle(slotIndex, slots[slotIndex].generation);
+    }
+};
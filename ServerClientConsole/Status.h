@@ -0,0 +1,28 @@
+#pragma once
+
+#define SUCCESS 0
+#define BIND_ERROR -1
+#define SETUP_ERROR -2
+#define CONNECT_ERROR -3
+#define SHUTDOWN -4
+#define DISCONNECT -5
+#define PARAMETER_ERROR -6
+#define SELECT_ERROR -7
+#define CAPACITY_ERROR -8
+#define NOT_FOUND -9
+#define AUTH_ERROR -10
+#define EXISTS_ERROR -11
+#define LOGIN_CONFLICT -12
+#define TIMEOUT_ERROR -13
+
+#define STATUS_CODES 14   // SUCCESS down to TIMEOUT_ERROR
+
+// Name of a status code above, for logs and metrics labels.
+inline const char* statusName(int status) {
+    static const char* names[STATUS_CODES] = {
+        "SUCCESS", "BIND_ERROR", "SETUP_ERROR", "CONNECT_ERROR", "SHUTDOWN", "DISCONNECT", "PARAMETER_ERROR",
+        "SELECT_ERROR", "CAPACITY_ERROR", "NOT_FOUND", "AUTH_ERROR", "EXISTS_ERROR", "LOGIN_CONFLICT",
+        "TIMEOUT_ERROR"
+    };
+    return (status <= 0 && status > -STATUS_CODES) ? names[-status] : "UNKNOWN";
+}
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+#include "SlotMap.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Handle of an armed timer. Cancelling one that already fired (or was never
+// armed, INVALID_HANDLE) is a harmless no-op.
+typedef SlotHandle TimerId;
+
+// Hierarchical timer wheel for one event loop: four levels of 64 slots, each
+// level's slot spanning a whole turn of the level below. A timer sits in the
+// slot of the level matching how far off it is and moves down a level when
+// its slot comes round (a "cascade"), so arm and cancel are O(1) and the wheel
+// never sorts. Timers are kept on intrusive lists threaded through a SlotMap,
+// with a bitmap of occupied slots per level, so the next tick with any work is
+// also O(1) and an idle loop can block until exactly then.
+class TimerWheel {
+private:
+    static const int LEVELS = 4;
+    static const int SLOT_BITS = 6;
+    static const uint32_t SLOTS = 1u << SLOT_BITS;
+    static const uint64_t MAX_DELTA = (1ull << (SLOT_BITS * LEVELS)) - 1;   // Farther timers wait in the top level
+
+    struct Timer {
+        std::function<void()> callback;
+        uint64_t due;       // Tick
+        TimerId prev;
+        TimerId next;
+        uint8_t level;
+        uint8_t slot;
+    };
+
+    SlotMap<Timer> timers;
+    TimerId heads[LEVELS][SLOTS];
+    uint64_t occupied[LEVELS];   // Bit per non-empty slot
+    std::chrono::steady_clock::time_point start;
+    uint64_t tickMillis;
+    uint64_t current;            // Last tick processed
+
+    static int lowestBit(uint64_t bits) {
+#if defined(_MSC_VER) && defined(_M_IX86)
+        // No 64-bit scan on 32-bit x86: try the low half, then the high
+        unsigned long index;
+        if (_BitScanForward(&index, static_cast<unsigned long>(bits))) {
+            return static_cast<int>(index);
+        }
+        _BitScanForward(&index, static_cast<unsigned long>(bits >> 32));
+        return static_cast<int>(index) + 32;
+#elif defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(bits);
+#endif
+    }
+
+    void link(TimerId id, Timer& timer) {
+        uint64_t delta = (timer.due > current) ? timer.due - current : 0;
+        uint64_t placed = current + ((delta > MAX_DELTA) ? MAX_DELTA : delta);
+        int level = 0;
+        while (level < LEVELS - 1 && (delta >> (SLOT_BITS * (level + 1))) != 0) {
+            level++;
+        }
+        uint32_t slot = static_cast<uint32_t>(placed >> (SLOT_BITS * level)) & (SLOTS - 1);
+
+        timer.level = static_cast<uint8_t>(level);
+        timer.slot = static_cast<uint8_t>(slot);
+        timer.prev = INVALID_HANDLE;
+        timer.next = heads[level][slot];
+        if (timer.next != INVALID_HANDLE) {
+            timers.get(timer.next)->prev = id;
+        }
+        heads[level][slot] = id;
+        occupied[level] |= 1ull << slot;
+    }
+
+    void unlink(Timer& timer) {
+        if (timer.prev != INVALID_HANDLE) {
+            timers.get(timer.prev)->next = timer.next;
+        }
+        else {
+            heads[timer.level][timer.slot] = timer.next;
+            if (timer.next == INVALID_HANDLE) {
+                occupied[timer.level] &= ~(1ull << timer.slot);
+            }
+        }
+        if (timer.next != INVALID_HANDLE) {
+            timers.get(timer.next)->prev = timer.prev;
+        }
+    }
+
+    // First tick after current at which the level's earliest non-empty slot
+    // comes round, or UINT64_MAX if the level is empty.
+    uint64_t nextTurn(int level) const {
+        if (occupied[level] == 0) {
+            return UINT64_MAX;
+        }
+        int shift = SLOT_BITS * level;
+        uint64_t base = current >> shift;
+        uint32_t from = static_cast<uint32_t>(base + 1) & (SLOTS - 1);
+        uint64_t rotated = (from == 0) ? occupied[level] : (occupied[level] >> from) | (occupied[level] << (SLOTS - from));
+        return (base + 1 + static_cast<uint64_t>(lowestBit(rotated))) << shift;
+    }
+
+    // Re-files every timer of the slot relative to the current tick.
+    void cascade(int level, uint32_t slot) {
+        TimerId id = heads[level][slot];
+        heads[level][slot] = INVALID_HANDLE;
+        occupied[level] &= ~(1ull << slot);
+        while (id != INVALID_HANDLE) {
+            Timer* timer = timers.get(id);
+            TimerId next = timer->next;
+            link(id, *timer);
+            id = next;
+        }
+    }
+
+    size_t expire() {
+        for (int level = LEVELS - 1; level > 0; level--) {
+            int shift = SLOT_BITS * level;
+            if ((current & ((1ull << shift) - 1)) == 0) {
+                cascade(level, static_cast<uint32_t>(current >> shift) & (SLOTS - 1));
+            }
+        }
+
+        // Callbacks may arm and cancel freely: new timers are due at least a
+        // tick later, so they never land in the slot being emptied
+        size_t fired = 0;
+        uint32_t slot = static_cast<uint32_t>(current) & (SLOTS - 1);
+        while (heads[0][slot] != INVALID_HANDLE) {
+            TimerId id = heads[0][slot];
+            Timer* timer = timers.get(id);
+            unlink(*timer);
+            std::function<void()> callback = std::move(timer->callback);
+            timers.erase(id);
+            callback();
+            fired++;
+        }
+        return fired;
+    }
+
+    uint64_t tickAt(std::chrono::steady_clock::time_point now) const {
+        if (now <= start) {
+            return 0;
+        }
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count()) / tickMillis;
+    }
+
+public:
+    explicit TimerWheel(uint32_t tickMillis = 10)
+        : start(std::chrono::steady_clock::now()), tickMillis(tickMillis ? tickMillis : 1), current(0) {
+        for (int level = 0; level < LEVELS; level++) {
+            occupied[level] = 0;
+            for (uint32_t slot = 0; slot < SLOTS; slot++) {
+                heads[level][slot] = INVALID_HANDLE;
+            }
+        }
+    }
+
+    size_t size() const { return timers.size(); }
+
+    // The wheel's clock: milliseconds since construction, as of the last
+    // advance() and in whole ticks. Free to read on every event.
+    uint64_t nowMillis() const { return current * tickMillis; }
+
+    // Runs callback on this loop once delayMillis have passed (rounded up to
+    // whole ticks, at least one).
+    TimerId arm(uint64_t delayMillis, std::function<void()> callback) {
+        uint64_t ticks = (delayMillis + tickMillis - 1) / tickMillis;
+        TimerId id = timers.emplace(Timer{ std::move(callback), current + (ticks ? ticks : 1),
+            INVALID_HANDLE, INVALID_HANDLE, 0, 0 });
+        link(id, *timers.get(id));
+        return id;
+    }
+
+    bool cancel(TimerId id) {
+        Timer* timer = timers.get(id);
+        if (!timer) {
+            return false;
+        }
+        unlink(*timer);
+        timers.erase(id);
+        return true;
+    }
+
+    // Fires every timer due by now; returns how many ran. Stretches with
+    // nothing due are skipped rather than stepped through tick by tick.
+    size_t advance(std::chrono::steady_clock::time_point now) {
+        uint64_t target = tickAt(now);
+        size_t fired = 0;
+        while (current < target) {
+            uint64_t next = nextTick();
+            if (next > target) {
+                break;
+            }
+            current = next;
+            fired += expire();
+        }
+        current = (target > current) ? target : current;
+        return fired;
+    }
+
+    // Next tick that has a timer to fire or to cascade; UINT64_MAX if none.
+    uint64_t nextTick() const {
+        uint64_t next = UINT64_MAX;
+        for (int level = 0; level < LEVELS; level++) {
+            uint64_t turn = nextTurn(level);
+            next = (turn < next) ? turn : next;
+        }
+        return next;
+    }
+
+    // Poll timeout that wakes the loop for the next timer: -1 with none armed.
+    int pollTimeout(std::chrono::steady_clock::time_point now) const {
+        uint64_t next = nextTick();
+        if (next == UINT64_MAX) {
+            return -1;
+        }
+        auto due = start + std::chrono::milliseconds(next * tickMillis);
+        if (due <= now) {
+            return 0;
+        }
+        // Round up so the loop never wakes a moment before the tick and spins
+        int64_t millis = std::chrono::duration_cast<std::chrono::milliseconds>(due - now + std::chrono::microseconds(999)).count();
+        return (millis > 60 * 60 * 1000) ? 60 * 60 * 1000 : static_cast<int>(millis);
+    }
+};
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "MappedFile.h"
+#include "PasswordHash.h"
+#include "Status.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Append-only account file. After the USER_STORE_MAGIC header every record is
+//   u8 type (USER_RECORD_ADD), u8 name length, name bytes,
+//   u8 logN, u8 r, u8 p, 16-byte salt, 32-byte scrypt hash
+// Loading maps the file and walks it once; no per-record allocation beyond
+// the directory entry itself.
+
+static const char USER_STORE_MAGIC[8] = { 'C', 'H', 'A', 'T', 'U', 'S', 'R', '1' };
+static const uint8_t USER_RECORD_ADD = 1;
+static const size_t USER_RECORD_FIXED = 1 + 1 + 3 + Credential::SALT_SIZE + Credential::HASH_SIZE;
+
+inline void encodeUserRecord(std::string& out, std::string_view username, const Credential& credential) {
+    out.push_back(static_cast<char>(USER_RECORD_ADD));
+    out.push_back(static_cast<char>(username.size()));
+    out.append(username.data(), username.size());
+    out.push_back(static_cast<char>(credential.logN));
+    out.push_back(static_cast<char>(credential.r));
+    out.push_back(static_cast<char>(credential.p));
+    out.append(reinterpret_cast<const char*>(credential.salt), Credential::SALT_SIZE);
+    out.append(reinterpret_cast<const char*>(credential.hash), Credential::HASH_SIZE);
+}
+
+// Bytes the record at data spans, or 0 if it is torn or malformed.
+inline size_t userRecordSize(const char* data, size_t available) {
+    if (available < USER_RECORD_FIXED || static_cast<uint8_t>(data[0]) != USER_RECORD_ADD) {
+        return 0;
+    }
+    size_t nameLength = static_cast<uint8_t>(data[1]);
+    size_t size = USER_RECORD_FIXED + nameLength;
+    return (nameLength == 0 || available < size) ? 0 : size;
+}
+
+// As userRecordSize, and also 0 for scrypt parameters outside what
+// validKdfParameters allows.
+inline size_t decodeUserRecord(const char* data, size_t available, std::string_view& username, Credential& credential) {
+    size_t size = userRecordSize(data, available);
+    if (size == 0) {
+        return 0;
+    }
+    size_t nameLength = static_cast<uint8_t>(data[1]);
+    const uint8_t* fields = reinterpret_cast<const uint8_t*>(data + 2 + nameLength);
+    if (!validKdfParameters(fields[0], fields[1], fields[2])) {
+        return 0;
+    }
+    username = std::string_view(data + 2, nameLength);
+    credential.logN = fields[0];
+    credential.r = fields[1];
+    credential.p = fields[2];
+    memcpy(credential.salt, fields + 3, Credential::SALT_SIZE);
+    memcpy(credential.hash, fields + 3 + Credential::SALT_SIZE, Credential::HASH_SIZE);
+    return size;
+}
+
+class UserStore {
+private:
+    std::mutex mutex;   // Serializes appends from worker threads
+    FILE* file;
+
+public:
+    std::atomic<uint64_t> accountsLoaded;
+    std::atomic<uint64_t> accountsRejected;   // Whole records with unusable scrypt parameters, skipped
+    std::atomic<uint64_t> accountsAppended;
+
+    UserStore() : file(nullptr), accountsLoaded(0), accountsRejected(0), accountsAppended(0) {}
+    ~UserStore() { close(); }
+
+    UserStore(const UserStore&) = delete;
+    UserStore& operator=(const UserStore&) = delete;
+
+    // Calls add(std::string_view username, const Credential&) for every stored
+    // account, drops a torn final record, then opens the file for appends.
+    // reserve(size_t) is called first with an estimate of the account count.
+    template <typename Reserve, typename Add>
+    int open(const std::string& path, Reserve reserve, Add add) {
+        std::error_code error;
+        uintmax_t fileSize = std::filesystem::file_size(path, error);
+        size_t valid = 0;
+        if (!error && fileSize > 0) {
+            MappedFile mapping;
+            if (fileSize < sizeof(USER_STORE_MAGIC) || !mapping.map(path, static_cast<size_t>(fileSize)) ||
+                std::string_view(mapping.data(), sizeof(USER_STORE_MAGIC)) != std::string_view(USER_STORE_MAGIC, sizeof(USER_STORE_MAGIC))) {
+                return SETUP_ERROR;   // Never append to a file we do not recognise
+            }
+            reserve(static_cast<size_t>(fileSize / (USER_RECORD_FIXED + 8)));
+            valid = sizeof(USER_STORE_MAGIC);
+            std::string_view username;
+            Credential credential;
+            for (;;) {
+                const char* record = mapping.data() + valid;
+                size_t available = mapping.size() - valid;
+                size_t size = decodeUserRecord(record, available, username, credential);
+                if (size > 0) {
+                    add(username, credential);
+                    accountsLoaded++;
+                }
+                else if ((size = userRecordSize(record, available)) > 0) {
+                    accountsRejected++;   // Not torn, so the records after it are kept
+                }
+                else {
+                    break;
+                }
+                valid += size;
+            }
+        }
+        if (!error && fileSize > valid && valid > 0) {
+            std::filesystem::resize_file(path, valid, error);
+        }
+
+        file = fopen(path.c_str(), "ab");
+        if (!file) {
+            return SETUP_ERROR;
+        }
+        if (valid == 0) {
+            fwrite(USER_STORE_MAGIC, 1, sizeof(USER_STORE_MAGIC), file);
+            fflush(file);
+        }
+        return SUCCESS;
+    }
+
+    // Durable before it returns; call from a worker thread, not an event loop.
+    int append(std::string_view username, const Credential& credential) {
+        std::string record;
+        encodeUserRecord(record, username, credential);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!file || fwrite(record.data(), 1, record.size(), file) != record.size() || fflush(file) != 0) {
+            return SETUP_ERROR;
+        }
+#ifdef _WIN32
+        _commit(_fileno(file));
+#else
+        fsync(fileno(file));
+#endif
+        accountsAppended++;
+        return SUCCESS;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (file) {
+            fclose(file);
+            file = nullptr;
+        }
+    }
+};
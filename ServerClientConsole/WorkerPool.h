@@ -0,0 +1,133 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Queue wait and run time for one kind of job, in microseconds.
+struct JobTimings {
+    std::atomic<uint64_t> runs;
+    std::atomic<uint64_t> waitMicros;
+    std::atomic<uint64_t> runMicros;
+    std::atomic<uint64_t> maxWaitMicros;
+    std::atomic<uint64_t> maxRunMicros;
+
+    JobTimings() : runs(0), waitMicros(0), runMicros(0), maxWaitMicros(0), maxRunMicros(0) {}
+
+    void record(uint64_t wait, uint64_t run) {
+        runs++;
+        waitMicros += wait;
+        runMicros += run;
+        raise(maxWaitMicros, wait);
+        raise(maxRunMicros, run);
+    }
+
+private:
+    static void raise(std::atomic<uint64_t>& maximum, uint64_t value) {
+        uint64_t seen = maximum.load(std::memory_order_relaxed);
+        while (value > seen && !maximum.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+    }
+};
+
+// Fixed set of threads for CPU-heavy or blocking jobs (password hashing, disk
+// writes, log scans) that must never run on an event loop. Jobs report back by
+// posting to the reactor that submitted them.
+class WorkerPool {
+private:
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::function<void()>> jobs;
+    std::vector<std::thread> threads;
+    size_t maxQueued;   // 0 = unbounded
+    bool stopping;
+    bool draining;      // Stopping, but only once the queue is empty
+
+    void workerLoop() {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping && (!draining || jobs.empty())) {
+                    return;
+                }
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            // A throwing job (e.g. bad_alloc) must not take the process down
+            try {
+                job();
+                jobsCompleted++;
+            }
+            catch (...) {
+                jobsFailed++;
+            }
+        }
+    }
+
+public:
+    std::atomic<uint64_t> jobsSubmitted;
+    std::atomic<uint64_t> jobsCompleted;
+    std::atomic<uint64_t> jobsRejected;
+    std::atomic<uint64_t> jobsFailed;      // Threw
+
+    WorkerPool() : maxQueued(0), stopping(false), draining(false), jobsSubmitted(0), jobsCompleted(0), jobsRejected(0), jobsFailed(0) {}
+    ~WorkerPool() { stop(); }
+
+    // maxQueued bounds the jobs waiting for a thread; submit refuses past it.
+    void start(int count, size_t maxQueued = 0) {
+        this->maxQueued = maxQueued;
+        stopping = false;
+        draining = false;
+        for (int i = 0; i < count; i++) {
+            threads.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    // False if the queue is full; the job is not run.
+    bool submit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (maxQueued > 0 && jobs.size() >= maxQueued) {
+                jobsRejected++;
+                return false;
+            }
+            jobs.push_back(std::move(job));
+        }
+        jobsSubmitted++;
+        ready.notify_one();
+        return true;
+    }
+
+    size_t threadCount() const { return threads.size(); }
+    size_t queueLimit() const { return maxQueued; }
+
+    size_t queued() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return jobs.size();
+    }
+
+    // Finishes the jobs already running. Queued ones are dropped, or with
+    // drain run first (for jobs that must not be lost, like disk writes).
+    void stop(bool drain = false) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            draining = drain;
+            if (!drain) {
+                jobs.clear();
+            }
+        }
+        ready.notify_all();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        threads.clear();
+    }
+};
@@ -0,0 +1,142 @@
+// Round trips and edge cases of the wire codec (FrameCodec.h). Run by ctest;
+// exits non-zero on the first failed check.
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "FrameCodec.h"
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            std::exit(1); \
+        } \
+    } while (0)
+
+static void testV1() {
+    std::string wire;
+    encodeV1(wire, "hello", 5);
+    DecodedFrame frame;
+    CHECK(decodeV1(wire.data(), wire.size(), frame) == DECODE_OK);
+    CHECK(frame.type == FRAME_TEXT && frame.frameSize == 6);
+    CHECK(std::string(frame.payload, frame.length) == "hello");
+
+    // Every truncation waits for more
+    for (size_t cut = 0; cut < wire.size(); cut++) {
+        CHECK(decodeV1(wire.data(), cut, frame) == DECODE_NEED_MORE);
+    }
+
+    // Long text is split over full frames, never truncated
+    std::string text(600, 'x');
+    wire.clear();
+    encodeV1(wire, text.data(), text.size());
+    CHECK(wire.size() == encodedSizeV1(text.size()));
+    std::string joined;
+    size_t offset = 0;
+    while (offset < wire.size()) {
+        CHECK(decodeV1(wire.data() + offset, wire.size() - offset, frame) == DECODE_OK);
+        joined.append(frame.payload, frame.length);
+        offset += frame.frameSize;
+    }
+    CHECK(joined == text);
+
+    // A zero length byte is never a v1 frame
+    CHECK(decodeV1("\0", 1, frame) == DECODE_ERROR);
+}
+
+static void testV2() {
+    std::string payload(300, 'y');
+    std::string wire;
+    encodeV2(wire, FRAME_TEXT, payload.data(), payload.size());
+    CHECK(wire.size() == encodedSizeV2(payload.size()));
+    DecodedFrame frame;
+    CHECK(decodeV2(wire.data(), wire.size(), frame) == DECODE_OK);
+    CHECK(frame.type == FRAME_TEXT && frame.frameSize == wire.size());
+    CHECK(std::string(frame.payload, frame.length) == payload);
+
+    for (size_t cut = 0; cut < wire.size(); cut++) {
+        CHECK(decodeV2(wire.data(), cut, frame) == DECODE_NEED_MORE);
+        // Once the length is in, callers learn the full size
+        CHECK(cut < 2 || frame.frameSize == wire.size());
+    }
+
+    // Empty body, oversized body, overlong varint
+    CHECK(decodeV2("\0", 1, frame) == DECODE_ERROR);
+    std::string oversized;
+    appendVarint(oversized, V2_MAX_PAYLOAD + 2);
+    CHECK(decodeV2(oversized.data(), oversized.size(), frame) == DECODE_ERROR);
+    std::string overlong(VARINT_MAX_BYTES, '\x80');
+    CHECK(decodeV2(overlong.data(), overlong.size(), frame) == DECODE_ERROR);
+
+    wire.clear();
+    encodeChatV2(wire, 123456, "hi", 2);
+    CHECK(wire.size() == encodedSizeChatV2(123456, 2));
+    CHECK(decodeV2(wire.data(), wire.size(), frame) == DECODE_OK);
+    uint64_t sequence;
+    const char* text;
+    size_t length;
+    CHECK(decodeChat(frame, sequence, text, length) && sequence == 123456 && std::string(text, length) == "hi");
+}
+
+static void testHello() {
+    std::string wire;
+    encodeHello(wire, PROTOCOL_V2);
+    uint8_t version = 0;
+    CHECK(wire.size() == HELLO_SIZE);
+    CHECK(decodeHello(wire.data(), wire.size(), version) == DECODE_OK && version == PROTOCOL_V2);
+
+    // A partial hello waits for the rest
+    for (size_t cut = 0; cut < HELLO_SIZE; cut++) {
+        CHECK(decodeHello(wire.data(), cut, version) == DECODE_NEED_MORE);
+    }
+
+    // A lone zero byte is ambiguous; a zero byte followed by anything but
+    // the magic is the old shutdown frame
+    CHECK(decodeHello("\0", 1, version) == DECODE_NEED_MORE);
+    CHECK(decodeHello("\0\5hello", 7, version) == DECODE_ERROR);
+    CHECK(decodeHello("\0R", 2, version) == DECODE_NEED_MORE);
+    CHECK(decodeHello("\0RX", 3, version) == DECODE_ERROR);
+    CHECK(decodeHello("\0RL\0", 4, version) == DECODE_ERROR);
+    CHECK(decodeHello("\5hello", 6, version) == DECODE_ERROR);
+}
+
+static void testBatch() {
+    BatchBuilder builder;
+    CHECK(builder.empty());
+    CHECK(builder.add(FRAME_TEXT, "one", 3));
+    CHECK(builder.add(FRAME_TEXT, "two", 3));
+    std::string wire;
+    builder.finish(wire);
+    CHECK(builder.empty());
+
+    DecodedFrame batch;
+    CHECK(decodeV2(wire.data(), wire.size(), batch) == DECODE_OK && batch.type == FRAME_BATCH);
+    BatchReader reader(batch.payload, batch.length);
+    DecodedFrame message;
+    CHECK(reader.next(message) == DECODE_OK && std::string(message.payload, message.length) == "one");
+    CHECK(reader.next(message) == DECODE_OK && std::string(message.payload, message.length) == "two");
+    CHECK(reader.next(message) == DECODE_NEED_MORE);
+
+    // A truncated or nested batch is malformed
+    BatchReader truncated(batch.payload, batch.length - 1);
+    CHECK(truncated.next(message) == DECODE_OK);
+    CHECK(truncated.next(message) == DECODE_ERROR);
+    BatchReader nested(wire.data(), wire.size());
+    CHECK(nested.next(message) == DECODE_ERROR);
+
+    // A batch never grows past one v2 frame
+    std::string big(V2_MAX_PAYLOAD / 2, 'z');
+    CHECK(builder.add(FRAME_TEXT, big.data(), big.size()));
+    CHECK(!builder.add(FRAME_TEXT, big.data(), big.size()));
+}
+
+int main() {
+    testV1();
+    testV2();
+    testHello();
+    testBatch();
+    std::printf("Codec tests passed\n");
+    return 0;
+}
@@ -0,0 +1,86 @@
+// Known-answer tests for the password hashing primitives (PasswordHash.h).
+// Run by ctest; exits non-zero on the first failed check.
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "PasswordHash.h"
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            std::exit(1); \
+        } \
+    } while (0)
+
+static std::string toHex(const uint8_t* bytes, size_t length) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    for (size_t i = 0; i < length; i++) {
+        hex += digits[bytes[i] >> 4];
+        hex += digits[bytes[i] & 0x0f];
+    }
+    return hex;
+}
+
+// FIPS 180-2, appendix B.1
+static void testSha256() {
+    Sha256 sha;
+    sha.update(reinterpret_cast<const uint8_t*>("abc"), 3);
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    sha.finish(digest);
+    CHECK(toHex(digest, sizeof(digest)) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+}
+
+// RFC 7914, section 11
+static void testPbkdf2() {
+    uint8_t out[64];
+    pbkdf2Sha256(reinterpret_cast<const uint8_t*>("passwd"), 6, reinterpret_cast<const uint8_t*>("salt"), 4, 1,
+        out, sizeof(out));
+    CHECK(toHex(out, sizeof(out)) ==
+          "55ac046e56e3089fec1691c22544b605f94185216dde0465e68b9d57c20dacbc"
+          "49ca9cccf179b645991664b39d77ef317c71b845b1e30bd509112041d3a19783");
+}
+
+// RFC 7914, section 12
+static void testScrypt() {
+    uint8_t out[64];
+    scrypt("", nullptr, 0, 4, 1, 1, out, sizeof(out));
+    CHECK(toHex(out, sizeof(out)) ==
+          "77d6576238657b203b19ca42c18a0497f16b4844e3074ae8dfdffa3fede21442"
+          "fcd0069ded0948f8326a753a0fc81f17e8d3e0fb2e0d3628cf35e20c38d18906");
+
+    scrypt("password", reinterpret_cast<const uint8_t*>("NaCl"), 4, 10, 8, 16, out, sizeof(out));
+    CHECK(toHex(out, sizeof(out)) ==
+          "fdbabe1c9d3472007856e7190d01e9fe7c6ad7cbc8237830e77376634b373162"
+          "2eaf30d92e22a3886ff109279d9830dac727afb94a83ee6d8360cbdfa2cc0640");
+}
+
+static void testParameters() {
+    CHECK(validKdfParameters(14, 8, 1));
+    CHECK(validKdfParameters(KDF_MAX_LOG_N, 8, 1));
+    CHECK(!validKdfParameters(0, 8, 1));
+    CHECK(!validKdfParameters(KDF_MAX_LOG_N + 1, 8, 1));
+    CHECK(!validKdfParameters(64, 8, 1));
+    CHECK(!validKdfParameters(14, 0, 1));
+    CHECK(!validKdfParameters(14, 8, 0));
+    CHECK(!validKdfParameters(14, 255, 255));
+    CHECK(!validKdfParameters(KDF_MAX_LOG_N, 64, 1));
+
+    KdfOptions options;
+    options.logN = 4;
+    Credential credential = hashPassword("secret", options);
+    CHECK(verifyPassword("secret", credential));
+    CHECK(!verifyPassword("Secret", credential));
+}
+
+int main() {
+    testSha256();
+    testPbkdf2();
+    testScrypt();
+    testParameters();
+    std::printf("KDF tests passed\n");
+    return 0;
+}